@@ -0,0 +1,25 @@
+#ifndef ASID_H
+#define ASID_H
+#include <umps3/umps/libumps.h>
+#include "pandos_const.h"
+#include "pandos_types.h"
+
+// ASID assegnabili agli U-proc: il campo della entry_hi ha 6 bit e l'ASID 0 e' riservato al kernel
+#define ASIDMAX 63
+
+// Inizializzazione dell'allocatore degli ASID
+void initASID();
+
+// Assegna all'U-proc dello slot (asid - 1) un ASID libero, rimuovendo dal TLB le traduzioni di un suo precedente proprietario
+int alloc_asid(int slot);
+
+// Rilascia l'ASID assegnato all'U-proc dello slot (asid - 1), rimuovendone le traduzioni dalla cache software
+void release_asid(int slot);
+
+// Ritorna lo slot (asid - 1) dell'U-proc a cui e' assegnato l'ASID, -1 se l'ASID e' libero
+int asid_slot(int asid);
+
+// Ritorna la generazione dell'ASID, incrementata ogni volta che l'ASID viene assegnato ad un nuovo U-proc
+unsigned int asid_generation(int asid);
+
+#endif
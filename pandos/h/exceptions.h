@@ -37,7 +37,7 @@ void create_process(state_t *a1_state, int a2_p_prio, support_t *a3_p_support_st
  */
 void terminate_process(int a1_pid);
 /**
- * Rimuove tutti i figli (ricorsivamente) del processo passato come parametro e li libera
+ * Rimuove tutti i discendenti (iterativamente, senza ricorsione) del processo passato come parametro e li libera
  * @param old_proc Il pcb del processo da terminare
  */
 void terminate_all(pcb_PTR old_proc);
@@ -77,7 +77,7 @@ void wait_for_clock(int *block_flag);
 void get_support_data();
 
 /**
- * NSYS9 - Se il pid del padre e' 0, ritorna il pcb del processo corrente, altrimenti ritorna il pcb del padre 
+ * NSYS9 - Se a1_parent e' 0, ritorna il PID del processo corrente, altrimenti il PID del padre (0 se non ha padre) 
  * 
  * @param a1_parent 0 if you want the current process, 1 if you want the parent process
  */
@@ -91,6 +91,16 @@ void get_processor_id(int a1_parent);
  */
 void yield(int *block_flag, int *low_priority);
 
+/**
+ * NSYS11 - Ritorna il PID di un figlio terminato e ne scrive lo stato di uscita in *a1_status (se non NULL), 
+ * bloccando il processo corrente finche' un figlio non termina. Ritorna NOPROC se il processo non ha figli
+ * 
+ * @param a1_status indirizzo in cui scrivere lo stato di uscita del figlio, o NULL
+ * @param a2_options WAITNOHANG per ritornare 0 invece di bloccarsi se nessun figlio e' ancora terminato
+ * @param block_flag flag che indica se il processo corrente e' da bloccare o no
+ */
+void wait_child(int *a1_status, int a2_options, int *block_flag);
+
 
 
 /**
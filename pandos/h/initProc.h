@@ -4,7 +4,25 @@
 #include "pandos_const.h"
 #include "vmSupport.h"
 
+// Valore di uproc_parent per gli slot non occupati da alcun U-proc
+#define SLOTFREE -2
+
 // Funzione di inizializzazione
 void test();
 
+// Inizializza le parti delle strutture di supporto che non cambiano tra un U-proc e il successivo (contesti, stack e page table vuota)
+void init_uproc_pool();
+
+// Assegna identificativo e ASID alla struttura di supporto dello slot i-esimo
+support_t *init_uproc_support(int i);
+
+// Prepara un U-proc figlio di parent (NOPROC per test) che esegue l'immagine sul device dev, ritorna il suo slot o -1; da chiamare in mutua esclusione sulla swap pool
+int load_uproc(int dev, int parent);
+
+// Crea il processo del nucleo per l'U-proc preparato nello slot i e ne registra il PID, ritorna il valore di NSYS1; da chiamare in mutua esclusione sulla swap pool
+int start_uproc(int i);
+
+// Assegna uno slot libero ad un nuovo U-proc figlio di parent, ritorna -1 se non ve ne sono
+int alloc_uproc_slot(int parent);
+
 #endif
\ No newline at end of file
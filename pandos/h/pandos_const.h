@@ -38,6 +38,11 @@
 
 #define MAXPROC 20
 
+/* PID: generation of the PCB slot in the high bits, slot index + 1 in the low PIDSHIFT bits */
+#define PIDSHIFT     8
+#define PIDINDEXMASK ((1 << PIDSHIFT) - 1)
+#define PIDGENMAX    (0x7FFFFFFF >> PIDSHIFT)
+
 #define CREATEPROCESS -1
 #define TERMPROCESS   -2
 #define PASSEREN      -3
@@ -48,6 +53,11 @@
 #define GETSUPPORTPTR -8
 #define GETPROCESSID  -9
 #define YIELD         -10
+#define WAITCHILD     -11
+
+/* WAITCHILD options and exit status of a process killed by the nucleus */
+#define WAITNOHANG   1
+#define KILLEDSTATUS -1
 
 
 #define PROCESS_PRIO_LOW  0
@@ -153,6 +163,9 @@
 #define VMDISK        0
 #define MAXPAGES      32
 #define USERPGTBLSIZE MAXPAGES
+#define KUSEGPAGES    0x40000      /* virtual pages between KUSEG and KUSEG3 */
+#define PGTBLSIZE     512          /* entries of a second level page table (one frame) */
+#define PGDIRSIZE     (KUSEGPAGES / PGTBLSIZE)
 #define OSFRAMES      32
 
 #define FLASHPOOLSTART (RAMSTART + (OSFRAMES * PAGESIZE))
@@ -166,6 +179,10 @@
 #define FLASHBACK    0
 #define BACKINGSTORE FLASHBACK
 
+#define PGTWOLEVEL   0
+#define PGINVERTED   1
+#define PGTABLEMODE  PGTWOLEVEL
+
 #define UPROCMAX 8
 #define POOLSIZE (UPROCMAX * 2)
 /* End of Mikeyg constants */
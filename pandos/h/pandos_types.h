@@ -34,11 +34,12 @@ typedef struct context_t {
 /* Support level descriptor */
 typedef struct support_t {
     int        sup_asid;                        /* process ID					*/
+    int        sup_tlbAsid;                     /* hardware ASID in EntryHi		*/
     state_t    sup_exceptState[2];              /* old state exceptions			*/
     context_t  sup_exceptContext[2];            /* new contexts for passing up	*/
-    pteEntry_t sup_privatePgTbl[USERPGTBLSIZE]; /* user page table				*/
-    int sup_stackTLB[500];
-    int sup_stackGen[500];
+#if PGTABLEMODE == PGTWOLEVEL
+    pteEntry_t *sup_pgDir[PGDIRSIZE];           /* user page directory			*/
+#endif
 } support_t;
 
 
@@ -67,6 +68,15 @@ typedef struct pcb_t {
 
     /* process id */
     int p_pid;
+
+    /* completion queue: terminated children not yet collected */
+    struct list_head p_done;
+    /* semaphore the process blocks on while waiting for a child */
+    int p_waitSem;
+    /* TRUE if terminated children wait on p_done for WAITCHILD (kernel-mode processes) */
+    int p_reaper;
+    /* exit status, valid while on the parent's completion queue */
+    int p_exitStatus;
 } pcb_t, *pcb_PTR;
 
 
@@ -87,6 +97,10 @@ typedef struct swap_t {
     int         sw_asid;   /* ASID number			*/
     int         sw_pageNo; /* page's virt page no.	*/
     pteEntry_t *sw_pte;    /* page's PTE entry.	*/
+    int         sw_flags;  /* frame state flags	*/
+    int         sw_refcnt; /* mappings of a shared frame	*/
+    unsigned int sw_image; /* image of a shared frame	*/
+    struct list_head sw_list; /* free list / ASID resident list */
 } swap_t;
 
 #endif
\ No newline at end of file
@@ -55,7 +55,7 @@ pcb_t* removeProcQ(struct list_head* head);
 /**
  * Rimuove il PCB puntato da p dalla coda dei processi puntata da tp.
  * Se p non è presente nella coda, restituisce NULL (p può trovarsi in una
- * posizione arbitraria della coda).
+ * posizione arbitraria della coda, ma non in una coda diversa da tp).
  */
 pcb_t* outProcQ(struct list_head* head, pcb_t* p);
 
@@ -88,4 +88,17 @@ pcb_t* outChild(pcb_t* p);
 void copy_state(state_t *a, state_t *b); 
 
 
+/**
+ * Restituisce il PCB del processo vivo con PID pid in O(1), NULL se il PID non
+ * e' valido o appartiene ad un processo gia' terminato (anche se il suo slot
+ * e' stato riutilizzato, grazie al numero di generazione).
+ */
+pcb_t* pid_lookup(int pid);
+
+/**
+ * Invalida il PID del PCB puntato da p: il processo e' terminato. Il campo
+ * p_pid resta disponibile per essere comunicato al padre.
+ */
+void pid_release(pcb_t* p);
+
 #endif
@@ -0,0 +1,50 @@
+#ifndef PGTABLE_H
+#define PGTABLE_H
+#include <umps3/umps/libumps.h>
+#include "pandos_const.h"
+#include "pandos_types.h"
+
+// Indice, a partire da KUSEG, della pagina che contiene l'indirizzo (o la entry_hi)
+#define KUSEGPAGE(addr) (((addr) - KUSEG) >> VPNSHIFT)
+// Indirizzo virtuale della pagina page di KUSEG
+#define PAGEADDR(page) (KUSEG + ((page) << VPNSHIFT))
+
+// Entry della page table invertita per ogni frame della swap pool (PGINVERTED)
+#define IPTFACTOR 4
+// Numero di bucket della tabella hash della page table invertita
+#define IPTBUCKETS 128
+
+// Entry della page table invertita, indicizzata per (ASID, VPN) tramite la entry_hi
+typedef struct ipt_t {
+	pteEntry_t ipt_pte;         /* entry_hi nulla se la entry e' libera */
+	struct list_head ipt_list;  /* bucket della tabella hash o lista delle entry libere */
+} ipt_t;
+
+// Inizializzazione della page table invertita, nelle entries entry a partire da start (non usata con PGTWOLEVEL)
+void initPgTable(ipt_t *start, int entries);
+
+// Inizializzazione della page table del processo, che non contiene ancora nessuna entry
+void init_pgtable(support_t *curr_support);
+
+// Ritorna TRUE se l'indirizzo appartiene all'address space di un U-proc (KUSEG o segmento condiviso)
+int legal_address(unsigned int entry_hi);
+
+// Ritorna la page table entry associata ad entry_hi, NULL se l'indirizzo non e' legale o la sua entry non e' stata allocata
+pteEntry_t *get_pte(support_t *curr_support, unsigned int entry_hi);
+
+// Come get_pte, ma alloca la entry (o la sua tabella di secondo livello) se necessario
+pteEntry_t *alloc_pte(support_t *curr_support, unsigned int entry_hi);
+
+// Ritorna il numero di frame liberi che alloc_pte userebbe per entry_hi, -1 se la entry non puo' essere allocata senza terminare il processo
+int pte_frames(support_t *curr_support, unsigned int entry_hi);
+
+// Ritorna la entry della pagina page di KUSEG, NULL se non e' stata allocata
+pteEntry_t *page_pte(support_t *curr_support, int page);
+
+// Ritorna la prossima entry allocata del processo a partire dalla posizione *cursor (inizialmente 0), NULL alla fine
+pteEntry_t *next_pte(support_t *curr_support, int *cursor);
+
+// Restituisce alla swap pool (o alla page table invertita) le entry del processo
+void free_pgtable(support_t *curr_support);
+
+#endif
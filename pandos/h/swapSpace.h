@@ -0,0 +1,68 @@
+#ifndef SWAPSPACE
+#define SWAPSPACE
+#include <umps3/umps/libumps.h>
+#include "pandos_const.h"
+#include "pandos_types.h"
+
+// Numero massimo di swap slot per flash device, ricavati a partire dall'ultimo blocco
+#define SWAPSLOTS 64
+#define SWAPSLOTWORDS (SWAPSLOTS / 32)
+
+// Valore del campo dev degli slot che si trovano sul disco VMDISK
+#define SWAPDISK -2
+// Pagine consecutive di un U-proc che occupano settori consecutivi dello stesso cilindro del disco
+#define SWAPCLUSTER 8
+// Numero massimo di cluster sul disco
+#define DISKCLUSTERS 64
+#define DISKCLUSTERWORDS (DISKCLUSTERS / 32)
+
+// Campi del registro DATA1 del disco, che ne descrive la geometria
+#define DISKMAXCYL(data1)  ((data1) >> 16)
+#define DISKMAXHEAD(data1) (((data1) >> 8) & 0xFF)
+#define DISKMAXSECT(data1) ((data1) & 0xFF)
+
+// Numero massimo di swap slot assegnati e numero di bucket della tabella hash che li indicizza
+#define SLOTRECORDS (DEVPERINT * SWAPSLOTS + DISKCLUSTERS * SWAPCLUSTER)
+#define SLOTBUCKETS 64
+
+// Posizione nella memoria secondaria della copia di una pagina di un U-proc
+typedef struct swap_slot_t {
+	int asid;     /* U-proc proprietario (asid - 1) */
+	int page;     /* pagina di KUSEG */
+	int dev;      /* flash device (o SWAPDISK) che contiene lo slot */
+	int block;    /* blocco del flash device o settore (in numerazione lineare) del disco */
+	int written;  /* lo slot contiene una copia della pagina (i cluster del disco sono assegnati prima della scrittura) */
+	struct list_head sl_list; /* bucket della tabella hash o lista degli slot liberi */
+} swap_slot_t;
+
+// Ricava i blocchi occupati dall'immagine e il numero di swap slot di ciascun flash device installato e, se usato, la geometria del disco
+void initSwapSpace();
+
+// Ritorna il numero di blocchi iniziali del flash device dev (o del disco, MMAPDISK) occupati dall'immagine aout che contiene
+int image_area_blocks(int dev);
+
+// Ritorna il primo blocco del flash device dev (o del disco, MMAPDISK) riservato agli swap slot, il numero di blocchi se non ne ospita
+int swap_area_start(int dev);
+
+// Ritorna il blocco in cui e' salvata la pagina dell'U-proc asid (asid - 1) e in dev il device, -1 se non e' mai stata salvata
+int swap_slot(int asid, int page, int *dev);
+
+// Come swap_slot, ma assegna uno slot libero (cluster del disco o flash device a rotazione) se la pagina non ne ha ancora uno, -1 se la memoria secondaria e' piena
+int alloc_swap_slot(int asid, int page, int *dev);
+
+// Scrive il frame nello swap slot della pagina, assegnandolo se necessario; termina il processo corrente se non ci sono slot liberi
+void swap_write(int frame, support_t *curr_support, int asid, int page);
+
+// Legge nel frame la pagina dal suo swap slot, ritorna FALSE se la pagina non ha uno slot
+int swap_read(int frame, support_t *curr_support, int asid, int page);
+
+// Libera tutti gli swap slot dell'U-proc asid (asid - 1)
+void free_swap_slots(int asid);
+
+// Ritorna il numero di settori del disco VMDISK, 0 se non e' installato
+int disk_blocks();
+
+// Esegue operation (DISKREAD/DISKWRITE) sul settore lineare block del disco VMDISK, spostando la testina solo se cambia cilindro, e ne ritorna lo stato
+int disk_transfer(int frame, int operation, int block);
+
+#endif
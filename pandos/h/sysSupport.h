@@ -7,6 +7,7 @@
 #include "pandos_types.h"
 #include "libumps.h"
 #include "interrupts.h"
+#include "cp0.h"
 
 #define PRINTCHR 2
 #define TERMSTATMASK 0xFF
@@ -16,8 +17,33 @@ void general_exception_handler();
 
 void get_tod (state_t *exception_state);
 
+// Termina il U-proc asid a causa di un errore, con stato di uscita KILLEDSTATUS
 void terminate (int asid);
 
+// Termina il U-proc asid e la sua discendenza, consegnando status al padre del nucleo
+void exit_uproc (int asid, int status);
+
+// Rilascia le risorse del livello di supporto del U-proc asid e di tutti i figli creati con FORK
+void release_uproc (int asid);
+
+// Crea un U-proc figlio che condivide copy-on-write l'address space del chiamante
+void fork_uproc (state_t *exception_state, support_t *curr_support);
+
+// Blocca in memoria un intervallo di pagine del chiamante
+void pin_uproc_pages (state_t *exception_state, support_t *curr_support);
+
+// Sblocca un intervallo di pagine del chiamante
+void unpin_uproc_pages (state_t *exception_state, support_t *curr_support);
+
+// Estende l'heap del chiamante, ritornando il vecchio limite
+void sbrk_uproc (state_t *exception_state, support_t *curr_support);
+
+// Mappa nell'address space del chiamante un intervallo di blocchi di un flash device o del disco
+void mmap_uproc (state_t *exception_state, support_t *curr_support);
+
+// Crea un U-proc figlio che esegue l'immagine aout contenuta in un flash device o nel disco, ritorna -1 se il device non ne contiene una valida
+void spawn_uproc (state_t *exception_state, support_t *curr_support);
+
 void write_to_printer (state_t *exception_state, int asid);
 
 void write_to_terminal (state_t *exception_state, int asid);
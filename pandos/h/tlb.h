@@ -0,0 +1,88 @@
+#ifndef SOFTTLB
+#define SOFTTLB
+
+#include <umps3/umps/libumps.h>
+#include "types.h"
+#include "pandos_const.h"
+#include "pandos_types.h"
+#include "cp0.h"
+#include "asid.h"
+
+// Numero di entry del TLB (tlb-size nella configurazione della macchina)
+#define TLBSIZE 16
+// Posizione del campo indice nel registro CP0.Index
+#define TLBINDEXSHIFT 8
+
+// Numero di entry della cache software delle traduzioni, che deve essere una potenza di 2
+#define STLBSIZE 64
+// Numero di entry consecutive esaminate per una chiave, a partire da quella indicata dalla funzione hash
+#define STLBPROBE 4
+// Ogni STLBAGING refill la distanza di riuso delle pagine nel TLB raddoppia, cosi' una pagina non piu' usata perde la protezione
+#define STLBAGING 256
+// Distanza di riuso di una pagina mai uscita dal TLB, considerata la meno usata
+#define STLBGAPMAX 0xFFFF
+
+// Numero di pagine piu' usate di ciascun ASID caricate nel TLB quando il processo torna in esecuzione
+#define TLBPRELOAD 4
+
+// Entry della cache software delle traduzioni
+typedef struct stlb_entry_t {
+	unsigned int key;       /* VPN e ASID (solo VPN per il segmento condiviso), 0 se la entry e' libera */
+	pteEntry_t *pte;        /* page table entry della pagina */
+	unsigned int reuse;     /* refill tra l'uscita dal TLB e il rientro, media delle ultime misure: piu' e' bassa piu' la pagina e' usata */
+	unsigned int evicted;   /* valore di tlb_stats.refills quando la pagina e' uscita dal TLB, 0 se non ne e' mai uscita */
+	int tlb_index;          /* posizione della pagina nel TLB, -1 se assente */
+} stlb_entry_t;
+
+// Contatori dei refill del TLB
+typedef struct tlb_stats_t {
+	unsigned int refills;       /* eccezioni di TLB-Refill */
+	unsigned int stlb_hits;     /* refill serviti dalla cache software */
+	unsigned int stlb_misses;   /* refill che hanno richiesto la ricerca nella page table */
+	unsigned int evictions;     /* entry del TLB sovrascritte */
+	unsigned int preloads;      /* entry caricate nel TLB al dispatch, prima del refill */
+} tlb_stats_t;
+
+// Inizializzazione della cache software delle traduzioni e della copia del contenuto del TLB
+void initTLB();
+
+// Carica nel TLB la traduzione di entry_hi, scegliendo la entry da sovrascrivere in base alla distanza di riuso delle pagine
+void tlb_refill(support_t *curr_support, unsigned int entry_hi);
+
+// Ritorna la chiave della cache software associata ad entry_hi
+unsigned int stlb_key(unsigned int entry_hi);
+
+// Ritorna la posizione nella cache software della traduzione di entry_hi, -1 se assente
+int stlb_lookup(unsigned int entry_hi);
+
+// Inserisce nella cache software la traduzione di entry_hi, rimpiazzando la entry meno usata tra quelle esaminate
+int stlb_insert(unsigned int entry_hi, pteEntry_t *pte);
+
+// Scrive nella entry index del TLB la pagina della entry e della cache software
+void tlb_write(int e, int index);
+
+// Scrive entry_hi ed entry_lo nella entry index del TLB, associandola alla entry e della cache software (-1 se nessuna)
+void tlb_place(int e, unsigned int entry_hi, unsigned int entry_lo, int index);
+
+// Aggiorna le pagine piu' usate dell'ASID dopo un refill della entry e della cache software
+void hot_update(int asid, int e);
+
+// Carica nel TLB le pagine piu' usate dell'ASID di entry_hi, da chiamare prima di mandare in esecuzione il processo
+void tlb_preload(unsigned int entry_hi);
+
+// Ritorna la entry del TLB da sovrascrivere: una libera o quella della pagina con la distanza di riuso maggiore
+int tlb_victim();
+
+// Rimuove dalla cache software le traduzioni e le pagine piu' usate dell'ASID, da chiamare con gli interrupt disabilitati quando l'ASID viene rilasciato
+void stlb_flush_asid(int asid);
+
+// Rimuove dalla cache software la traduzione di entry_hi, da chiamare quando la sua page table entry viene liberata
+void stlb_remove(unsigned int entry_hi);
+
+// Rimuove dal TLB e dalla cache software le traduzioni dell'ASID, da chiamare con gli interrupt disabilitati quando l'ASID viene riassegnato
+void tlb_flush_asid(int asid);
+
+// Da chiamare dopo TLBCLR: nessuna pagina della cache software e' piu' nel TLB
+void tlb_shadow_clear();
+
+#endif
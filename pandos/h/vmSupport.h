@@ -5,17 +5,342 @@
 #include "pandos_types.h"
 #include "interrupts.h"
 #include "sysSupport.h"
+#include "cp0.h"
+#include "zswap.h"
+#include "swapSpace.h"
+#include "tlb.h"
+#include "pgTable.h"
 
-#define POOLSTART 0x20020000
+// Frame sotto il RAMTOP riservati agli stack del livello di supporto (due per U-proc) e allo stack di test
+#define SUPSTACKFRAMES (UPROCMAX * 2 + 1)
+
+// Indirizzo fisico del frame i-esimo della swap pool
+#define FRAMEADDR(i) (swap_pool_start + ((i) * PAGESIZE))
+
+// Offset dei campi dell'header aout (posto all'inizio della sezione .text)
+#define AOUT_TAG         0x0000
+#define AOUT_ENTRY       0x0004
+#define AOUT_TEXTVADDR   0x0008
+#define AOUT_TEXTMEMSZ   0x000C
+#define AOUT_TEXTFILESZ  0x0014
+#define AOUT_DATAVADDR   0x0018
+#define AOUT_DATAMEMSZ   0x001C
+#define AOUT_DATAFILESZ  0x0024
+// Valore del campo AOUT_TAG nelle immagini aout generate da umps3-elf2umps
+#define AOUTFILEID       0x0041534D
+
+// Flag dello stato di un frame della swap pool (campo sw_flags)
+#define SW_PREFETCHED 0x1   /* pagina letta in anticipo e non ancora acceduta */
+#define SW_PINNED     0x2   /* frame bloccato in memoria, escluso dal rimpiazzamento */
+#define SW_REFERENCED 0x4   /* pagina acceduta dall'ultimo campionamento del working set */
+#define SW_DIRTY      0x8   /* pagina di una regione mappata modificata dopo essere stata letta dal device */
+#define SW_BUSY       0x10  /* frame in transito durante un page fault (I/O fuori dalla mutua esclusione), escluso dal rimpiazzamento */
+
+// Valore di sw_asid dei frame che appartengono alla page cache delle pagine di .text condivise
+#define PAGECACHE -2
+// Valore di sw_asid dei frame del segmento condiviso KUSEG3
+#define SHAREDSEG -3
+// Valore di sw_asid dei frame condivisi copy-on-write tra padre e figli creati con FORK
+#define COWFRAME -4
+// Valore di sw_asid dei frame che contengono una tabella di secondo livello della page table di un U-proc
+#define PGTABLE -5
+// Numero di pagine del segmento condiviso KUSEG3
+#define SHAREDPAGES 32
+
+// Numero di bucket della tabella hash della page cache
+#define PAGECACHESIZE 32
+
+// Numero massimo di pagine che un U-proc puo' bloccare in memoria
+#define PINMAX 8
+
+// Pagina di KUSEG che contiene la cima dello stack degli U-proc
+#define STACKTOPPAGE KUSEGPAGE(USERSTACKTOP - PAGESIZE)
+// Numero massimo di pagine dello stack di un U-proc; la pagina sottostante fa da guardia
+#define STACKMAXPAGES 16
+#define STACKGUARDPAGE (STACKTOPPAGE - STACKMAXPAGES)
+// Numero massimo di pagine dell'heap di un U-proc, che inizia dopo la fine dell'immagine
+#define HEAPMAXPAGES 64
+
+// Regioni di device che un U-proc puo' mappare, ciascuna in una finestra di MMAPPAGES pagine a partire da MMAPBASEPAGE
+#define MMAPMAX 4
+#define MMAPPAGES 256
+#define MMAPBASEPAGE (KUSEGPAGES / 2)
+// Valore di dev che indica il disco VMDISK (i flash device sono indicati dal loro numero)
+#define MMAPDISK DEVPERINT
+
+// Se attivo, all'avvio di un U-proc vengono caricate la pagina di UPROCSTARTADDR e la pagina di stack, senza attendere i page fault
+#define LAUNCHPRELOAD 1
+
+// Dimensione massima della finestra di lettura anticipata (in pagine)
+#define PREFETCHMAX 8
+
+// Intervallo (in microsecondi) tra due campionamenti del working set di un U-proc
+#define WSINTERVAL 100000
+// Frame concessi oltre il working set stimato, e quota minima di frame residenti
+#define WSMARGIN 2
+#define WSMIN 4
+
+// Stato del riconoscimento dei pattern di accesso di un U-proc
+typedef struct prefetch_t {
+	int last_page;  /* ultima pagina che ha causato un page fault */
+	int stride;     /* distanza tra gli ultimi due page fault */
+	int window;     /* numero di pagine da leggere in anticipo */
+} prefetch_t;
+
+// Identita' dell'immagine contenuta nel device dev (flash device o MMAPDISK) alla generazione gen, condivisa dai device con lo stesso contenuto
+#define IMAGEID(dev, gen) (((gen) << 4) | ((dev) + 1))
+
+// Informazioni sull'immagine aout di un U-proc, ricavate dall'header
+typedef struct image_t {
+	int parsed;            /* l'header e' gia' stato letto */
+	int file_pages;        /* pagine (a partire da KUSEG) presenti nel file, le successive sono .bss */
+	int mem_pages;         /* pagine (a partire da KUSEG) occupate dall'immagine in memoria, .bss compresa */
+	int text_pages;        /* pagine di sola .text, condivise tramite la page cache */
+	unsigned int image_id; /* identita' del contenuto dell'immagine (IMAGEID), chiave della page cache */
+	int image_dev;         /* flash device (o MMAPDISK) che contiene l'immagine */
+	support_t *support;    /* struttura di supporto del processo */
+} image_t;
+
+// Regione di un flash device o del disco mappata nell'address space di un U-proc
+typedef struct mmap_t {
+	int dev;    /* flash device o MMAPDISK */
+	int block;  /* primo blocco (o settore lineare del disco) della regione */
+	int pages;  /* pagine mappate, 0 se la finestra e' libera */
+} mmap_t;
+
+// Resident set e working set di un U-proc
+typedef struct wset_t {
+	int resident;       /* frame privati residenti */
+	int wss;            /* stima del working set all'ultimo campionamento */
+	int quota;          /* frame residenti oltre i quali, sotto pressione, il processo rimpiazza le proprie pagine */
+	cpu_t last_sample;  /* TOD dell'ultimo campionamento */
+	int suspended;      /* processo sospeso dal controllo di ammissione */
+} wset_t;
+
+// Stato dell'I/O del pager di un U-proc, i cui trasferimenti possono avvenire fuori dalla mutua esclusione sulla swap pool
+typedef struct io_t {
+	int in_pager;          /* il processo sta servendo un page fault */
+	int unlock;            /* i trasferimenti in corso rilasciano la mutua esclusione sulla swap pool */
+	int active;            /* trasferimento in corso sul device */
+	int owner;             /* U-proc (asid - 1) a cui appartiene la pagina trasferita */
+	int page;              /* pagina trasferita */
+	unsigned int waiters;  /* processi da svegliare (bit asid - 1, UPROCMAX per test) a fine trasferimento o all'uscita dal pager */
+	int doomed;            /* il processo sta per essere eliminato: all'uscita dal pager si ferma */
+} io_t;
+
+// Contatori del pager
+typedef struct pager_stats_t {
+	unsigned int misses;           /* page fault serviti con una lettura dal flash device */
+	unsigned int zero_fills;       /* page fault serviti azzerando un frame */
+	unsigned int cache_hits;       /* page fault serviti da una pagina della page cache */
+	unsigned int cow_copies;       /* pagine copiate alla prima scrittura dopo una FORK */
+	unsigned int prefetched;       /* pagine lette in anticipo */
+	unsigned int prefetch_hits;    /* page fault serviti da una pagina letta in anticipo */
+	unsigned int prefetch_wasted;  /* pagine lette in anticipo e liberate senza essere usate */
+	unsigned int ref_faults;       /* page fault senza I/O dovuti al campionamento del working set */
+	unsigned int local_evictions;  /* rimpiazzamenti tra le pagine del processo stesso, oltre la quota */
+	unsigned int suspensions;      /* sospensioni del controllo di ammissione */
+	unsigned int cluster_evictions; /* pagine salvate sul disco insieme alla vittima del loro cluster */
+	unsigned int stack_growths;    /* page fault che hanno esteso lo stack di un U-proc */
+} pager_stats_t;
 
 // Page fault exception handler
 void pager(); 
 
-// Algoritmo di rimpiazzamento 
+// Algoritmo di rimpiazzamento, ritorna -1 se tutti i frame sono bloccati in memoria
 int replacement_algorithm(); 
 
-// Funzione che esegue una operazione in base al valore di operation sul flash device appropriato
-void flash_device_operation(int frame, int operation, support_t *curr_support, int block_number);
+// Serve il page fault sulla pagina page_missing di KUSEG
+void page_fault(support_t *curr_support, int page_missing);
+
+// Ritorna TRUE se la pagina di KUSEG appartiene all'address space del processo, estendendo lo stack se la pagina e' sotto la sua base
+int user_page(support_t *curr_support, int page);
+
+// Sposta in avanti di increment byte la fine dell'heap del processo, ritorna il vecchio limite o -1 se supera HEAPMAXPAGES
+memaddr heap_grow(support_t *curr_support, int increment);
+
+// Mappa pages blocchi del device dev a partire da block in una finestra libera, ritorna l'indirizzo della regione o -1 (anche se i blocchi si sovrappongono all'immagine o agli swap slot)
+memaddr mmap_region(support_t *curr_support, int dev, int block, int pages);
+
+// Ritorna il blocco del device da cui e' mappata la pagina del processo asid (asid - 1) e in dev il device, -1 se non e' mappata
+int mmap_block(int asid, int page, int *dev);
+
+// Esegue operation (lettura o scrittura) tra il frame e il blocco del device mappato dalla pagina
+void mmap_operation(int frame, int write, support_t *curr_support, int asid, int page);
+
+// Gestisce la prima scrittura su una pagina mappata, ritorna FALSE se la pagina non lo e'
+int mmap_dirty(support_t *curr_support, pteEntry_t *pte);
+
+// Gestisce la scrittura su una pagina copy-on-write, ritorna FALSE se la pagina non lo e'
+int copy_on_write(support_t *curr_support, pteEntry_t *pte);
+
+// Condivide copy-on-write con il figlio le pagine del padre, da chiamare in mutua esclusione sulla swap pool
+void vm_fork(support_t *parent, support_t *child);
+
+// Blocca in memoria le pagine dell'intervallo [start, start + len), ritorna FALSE se l'intervallo non e' valido o supera il limite
+int pin_pages(support_t *curr_support, memaddr start, unsigned int len);
+
+// Sblocca le pagine dell'intervallo [start, start + len) bloccate dal processo
+void unpin_pages(support_t *curr_support, memaddr start, unsigned int len);
+
+// Carica in un frame bloccato in memoria la pagina del segmento condiviso associata a pte
+void map_shared_segment(support_t *curr_support, pteEntry_t *pte);
+
+// Ritorna l'indice del frame della swap pool a cui punta il campo PFN di entry_lo, -1 se fuori dalla swap pool
+int pfn_frame(unsigned int entry_lo);
+
+// Ritorna il frame che contiene la pagina page del processo, anche se la entry non e' valida, -1 altrimenti
+int resident_frame(support_t *curr_support, int page);
+
+// Ritorna un frame libero, liberandone uno tramite l'algoritmo di rimpiazzamento se necessario
+int get_frame(support_t *curr_support);
+
+// Ritorna il frame privato del processo da rimpiazzare quando supera la propria quota, -1 se non ce ne sono
+int local_victim(int asid);
+
+// Stima periodicamente il working set del processo, invalidando le pagine per registrarne il prossimo accesso
+void sample_working_set(support_t *curr_support);
+
+// Ritorna TRUE se il processo deve essere sospeso perche' la somma dei working set supera la swap pool
+int admission_control(int asid);
+
+// Riattiva i processi sospesi il cui working set rientra nella swap pool
+void admit_suspended();
+
+// Azzera lo stato del working set dell'U-proc asid (asid - 1)
+void reset_working_set(int asid);
+
+// Invalida la pagina contenuta nel frame victim_frame e la salva sul flash device del proprietario
+void evict_frame(int victim_frame, support_t *curr_support);
+
+// Invalida la pagina privata contenuta nel frame e la salva in memoria secondaria
+void evict_private_frame(int victim_frame, support_t *curr_support);
+
+// Rimpiazza un frame copy-on-write, salvandone il contenuto sul flash device di ogni processo che lo mappa
+void evict_cow_frame(int victim_frame, support_t *curr_support);
+
+// Associa il frame alla pagina page del processo, aggiornando swap pool, page table e TLB
+void map_frame(support_t *curr_support, int page, int frame, unsigned int valid);
+
+// Riconosce accessi sequenziali (o a passo costante) e legge in anticipo le pagine successive in frame liberi
+void prefetch(support_t *curr_support, int page);
+
+// Aggiorna i contatori quando una pagina letta in anticipo viene liberata senza essere stata usata
+void prefetch_wasted(int asid);
+
+// Ritorna il numero di pagine (a partire da KUSEG) presenti nel file dell'immagine aout con header all'indirizzo header, -1 se non e' un'immagine aout di un U-proc
+int aout_file_pages(memaddr header);
+
+// Ricava dall'header aout, contenuto nel frame, la parte file-backed e la parte condivisibile dell'immagine del processo
+void parse_aout_header(support_t *curr_support, int frame);
+
+// Da chiamare dopo ogni scrittura sul blocco block del device dev: se il blocco appartiene all'immagine, le sue pagine in cache non sono piu' valide
+void image_written(int dev, int block);
+
+// Ritorna TRUE se la pagina contiene solo .text e puo' quindi essere condivisa
+int is_shared_text(int asid, int page);
+
+// Ritorna il frame della page cache che contiene la pagina page dell'immagine image_id, -1 se assente
+int cache_lookup(unsigned int image_id, int page);
+
+// Inserisce il frame nella page cache
+void cache_insert(int frame, unsigned int image_id, int page);
+
+// Rimuove il frame dalla page cache, invalidando le entry di tutti i processi che lo mappano
+void cache_remove(int frame);
+
+// Mappa in sola lettura il frame condiviso nella page table del processo
+void map_shared(support_t *curr_support, int page, int frame);
+
+// Ritorna TRUE se la pagina e' oltre la parte file-backed e non e' mai stata salvata in memoria secondaria
+int is_demand_zero(int asid, int page);
+
+// Azzera il contenuto del frame
+void zero_frame(int frame);
+
+// Salva nel cluster del disco la vittima e le pagine vicine dello stesso processo non accedute di recente
+void evict_cluster(int victim_frame, support_t *curr_support);
+
+// Legge in anticipo in frame liberi le pagine successive a page salvate nello stesso cluster del disco
+void cluster_read_ahead(support_t *curr_support, int page);
+
+// Salva la pagina contenuta nel frame nel tier compresso o, se non c'e' spazio, sul flash device dell'U-proc asid (asid - 1)
+void swap_out(int frame, support_t *curr_support, int asid, int page);
+
+// Carica nel frame la pagina dell'U-proc asid (asid - 1) dal tier compresso o dal flash device
+void swap_in(int frame, support_t *curr_support, int asid, int page);
+
+// Legge (o scrive, se write) nel frame il blocco block del flash device dev (o del disco, se dev e' MMAPDISK o SWAPDISK), e ritorna lo stato del device
+int device_transfer(int frame, int write, int dev, int block);
+
+// Trasferimento del pager della pagina page dell'U-proc owner (asid - 1): durante un page fault avviene fuori dalla mutua esclusione sulla swap pool. Termina il processo corrente in caso di errore
+void pager_io(support_t *curr_support, int frame, int write, int dev, int block, int owner, int page);
+
+// Ritorna l'U-proc (asid - 1) che sta trasferendo la pagina page (-1 per qualsiasi pagina) dell'U-proc owner fuori dalla mutua esclusione, -1 se nessuno
+int page_io_doer(int owner, int page);
+
+// Attende, rilasciando la mutua esclusione sulla swap pool, che nessun U-proc stia trasferendo la pagina page (-1 per qualsiasi pagina) di owner
+void wait_page_io(int owner, int page);
+
+// Ritorna TRUE se l'U-proc asid (asid - 1) sta servendo un page fault, e potrebbe quindi avere un trasferimento in corso
+int pager_busy(int asid);
+
+// Attende, rilasciando la mutua esclusione sulla swap pool, la fine di un trasferimento di doer o la sua uscita dal pager; se doom, doer si ferma all'uscita dal pager
+void wait_io(int doer, int doom);
+
+// Sveglia i processi in attesa sull'U-proc asid (asid - 1) e ne azzera lo stato dell'I/O del pager, da chiamare quando lo slot viene rilasciato
+void reset_io_state(int asid);
+
+// Legge nel frame la pagina page dell'immagine del processo asid (asid - 1) dal suo flash device o dal disco, e ritorna lo stato del device
+int image_transfer(int frame, int asid, int page);
+
+// Come image_transfer, ma termina il processo corrente in caso di errore
+void image_read(int frame, support_t *curr_support, int asid, int page);
+
+// Ritorna il numero di blocchi del device che contiene l'immagine del processo asid (asid - 1)
+int image_blocks(int asid);
+
+// Prepara la paginazione su richiesta di un nuovo U-proc, la cui immagine si trova sul device dev (flash device o MMAPDISK); ritorna -1 se il device non contiene un'immagine aout valida. Da chiamare in mutua esclusione sulla swap pool
+int vm_load(support_t *curr_support, int dev);
+
+// Carica, usando solo frame liberi, la prima pagina e la pagina di stack di un U-proc preparato da vm_load; ritorna -1 se la lettura dell'immagine fallisce. Da chiamare in mutua esclusione sulla swap pool
+int vm_preload(support_t *curr_support);
+
+// Ritorna il numero di blocchi del flash device associato all'asid (asid - 1)
+int flash_blocks(int asid);
+
+// Esegue operation (FLASHREAD/FLASHWRITE) sul blocco block del flash device dev, e ne ritorna lo stato
+int flash_transfer(int frame, int operation, int dev, int block);
+
+// Estrae un frame dalla lista dei frame liberi in tempo costante, ritorna -1 se la lista e' vuota
+int alloc_frame();
+
+// Ritorna il numero di frame nella lista dei frame liberi
+int free_frames();
+
+// Ritorna il numero di frame bloccati in memoria, per qualsiasi motivo (SYS7, tabelle di secondo livello, segmento condiviso)
+int pinned_frames();
+
+// Registra che l'U-proc asid (asid - 1) mappa il frame condiviso, incrementandone il numero di riferimenti
+void share_frame(int asid, int frame);
+
+// Registra che l'U-proc asid (asid - 1) non mappa piu' il frame condiviso
+void unshare_frame(int asid, int frame);
+
+// Ritorna TRUE se l'U-proc asid (asid - 1) mappa il frame condiviso
+int maps_shared(int asid, int frame);
+
+// Blocca il frame in memoria, escludendolo dal rimpiazzamento e contandolo in pinned_frames
+void pin_frame(int frame);
+
+// Sblocca il frame, se era bloccato
+void unpin_frame(int frame);
+
+// Restituisce il frame alla lista dei frame liberi
+void release_frame(int frame);
+
+// Restituisce alla lista dei frame liberi tutti i frame occupati dal U-proc asid (asid - 1)
+void free_asid_frames(int asid);
 
 // Funzione di inizializzazione della swap pool table, del semaforo associato e del vettore swap_pool_holding
 void initSwapStructs();
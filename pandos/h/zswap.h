@@ -0,0 +1,58 @@
+#ifndef ZSWAP
+#define ZSWAP
+#include <umps3/umps/libumps.h>
+#include "pandos_const.h"
+#include "pandos_types.h"
+
+// Un frame ogni ZSWAPRATIO dell'area della swap pool e' riservato al tier compresso, 0 disabilita il tier
+#define ZSWAPRATIO 8
+
+// Parole contenute in un chunk del tier compresso
+#define ZCHUNKWORDS 64
+#define ZCHUNKSPERFRAME (PAGESIZE / WORDLEN / ZCHUNKWORDS)
+// Una pagina viene conservata compressa solo se la codifica occupa al massimo meta' frame
+#define ZMAXWORDS (PAGESIZE / WORDLEN / 2)
+
+// Fine della lista dei chunk
+#define ZNONE -1
+
+// Numero massimo di pagine nel tier compresso e numero di bucket della tabella hash che le indicizza
+#define ZSWAPENTRIES 256
+#define ZSWAPBUCKETS 32
+
+// Copia compressa della pagina di un U-proc
+typedef struct zswap_t {
+	int asid;               /* U-proc proprietario (asid - 1) */
+	int page;               /* pagina di KUSEG */
+	int chunk;              /* primo chunk della codifica, ZNONE se la pagina ripete sempre la stessa parola */
+	unsigned int fill;      /* parola ripetuta, per le pagine di parole tutte uguali */
+	struct list_head z_list; /* bucket della tabella hash o lista delle entry libere */
+} zswap_t;
+
+// Contatori del tier compresso
+typedef struct zswap_stats_t {
+	unsigned int stores;       /* pagine salvate nel tier compresso */
+	unsigned int same_filled;  /* pagine di parole tutte uguali, salvate senza occupare chunk */
+	unsigned int loads;        /* page fault serviti dal tier compresso, senza I/O */
+	unsigned int overflows;    /* pagine scritte sul flash device perche' incomprimibili o per tier pieno */
+} zswap_stats_t;
+
+// Inizializza il tier compresso nei frames frame a partire da start, next ha un elemento per ogni chunk
+void zswap_init(memaddr start, int frames, int *next);
+
+// Comprime la pagina all'indirizzo fisico page_addr, ritorna FALSE se non c'e' spazio o la pagina e' incomprimibile
+int zswap_store(memaddr page_addr, int asid, int page);
+
+// Decomprime la pagina in page_addr e la rimuove dal tier, ritorna FALSE se non e' presente
+int zswap_load(memaddr page_addr, int asid, int page);
+
+// Ritorna TRUE se la pagina page dell'U-proc asid (asid - 1) e' nel tier compresso
+int zswap_contains(int asid, int page);
+
+// Rimuove dal tier la copia compressa della pagina, se presente
+void zswap_drop(int asid, int page);
+
+// Rimuove dal tier tutte le pagine dell'U-proc asid (asid - 1)
+void zswap_drop_asid(int asid);
+
+#endif
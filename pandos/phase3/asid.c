@@ -0,0 +1,64 @@
+#include "../h/asid.h"
+#include "../h/tlb.h"
+
+// Slot dell'U-proc a cui e' assegnato ciascun ASID, -1 se l'ASID e' libero
+HIDDEN int asid_owner[ASIDMAX + 1];
+// Generazione di ciascun ASID, 0 se l'ASID non e' mai stato assegnato
+HIDDEN unsigned int asid_gen[ASIDMAX + 1];
+// ASID da cui parte la ricerca del prossimo ASID libero
+HIDDEN int next_asid;
+
+void initASID(){
+	for (int asid = 0; asid <= ASIDMAX; asid++){
+		asid_owner[asid] = -1;
+		asid_gen[asid] = 0;
+	}
+	next_asid = 1;
+}
+
+int alloc_asid(int slot){
+	/*
+		Gli ASID vengono assegnati a rotazione: un ASID torna in uso solo dopo che sono stati assegnati tutti gli altri,
+		cosi' le sue traduzioni rimaste nel TLB vengono rimosse raramente e solo per quell'ASID, senza svuotare tutto il TLB.
+	*/
+	for (int i = 0; i < ASIDMAX; i++){
+		int asid = next_asid;
+		next_asid = next_asid % ASIDMAX + 1;
+		// L'ASID del delay daemon non viene mai assegnato agli U-proc
+		if (asid_owner[asid] != -1 || asid == DELAYASID)
+			continue;
+		if (asid_gen[asid] != 0){
+			setSTATUS(getSTATUS() & DISABLEINTS);
+			tlb_flush_asid(asid);
+			setSTATUS(getSTATUS() | IECON);
+		}
+		asid_owner[asid] = slot;
+		asid_gen[asid]++;
+		return asid;
+	}
+	// Gli slot sono meno degli ASID, quindi un ASID libero esiste sempre
+	PANIC();
+	return -1;
+}
+
+void release_asid(int slot){
+	for (int asid = 1; asid <= ASIDMAX; asid++)
+		if (asid_owner[asid] == slot){
+			/*
+				La cache software contiene puntatori alle page table entry del processo, che vengono liberate con lui:
+				va svuotata subito. Le entry del TLB hardware vengono invece rimosse quando l'ASID viene riassegnato.
+			*/
+			setSTATUS(getSTATUS() & DISABLEINTS);
+			stlb_flush_asid(asid);
+			setSTATUS(getSTATUS() | IECON);
+			asid_owner[asid] = -1;
+		}
+}
+
+int asid_slot(int asid){
+	return (asid < 1 || asid > ASIDMAX) ? -1 : asid_owner[asid];
+}
+
+unsigned int asid_generation(int asid){
+	return asid_gen[asid];
+}
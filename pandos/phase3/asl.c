@@ -102,14 +102,8 @@ void initASL() {
 HIDDEN int is_proc_in_semd(semd_t *s, pcb_t *p) {
 	if (s == NULL) 
 		return FALSE;
-	struct list_head *iter;
-	// Per ogni elemento della lista dei processi bloccati di s
-	list_for_each(iter,&(s->s_procq)) {										
-		if (container_of(iter, pcb_t, p_list) == p)							
-		// Se il PCB si trova nella lista dei processi bloccati sul semaforo
-			return TRUE;
-	}
-	return FALSE;
+	// Un PCB si trova nella coda del semaforo su cui e' bloccato, e p_list e' vuoto solo fuori da ogni coda: verifica in O(1)
+	return p->p_semAdd == s->s_key && !list_empty(&(p->p_list));
 }
 
 HIDDEN semd_PTR getSemd(int *key) { 
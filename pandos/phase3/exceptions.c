@@ -15,6 +15,8 @@ extern int p_count;
 // Processi bloccati, che stanno aspettando una operazione di I/O
 extern int soft_counter;                                
 extern void scheduler(); 
+extern void tlb_refill(support_t *curr_support, unsigned int entry_hi);
+extern void tlb_preload(unsigned int entry_hi);
 
 cpu_t exception_time; 
 state_t *exception_state; 
@@ -95,7 +97,12 @@ void syscall_handler() {
             {
                 // PID del processo chiamante
                 int a1_pid = exception_state->reg_a1;                       
+                // Stato di uscita, consegnato al padre tramite WAITCHILD
+                int a2_status = exception_state->reg_a2;
 
+                pcb_PTR old_proc = (a1_pid == 0) ? current_p : pid_lookup(a1_pid);
+                if (old_proc != NULL)
+                    old_proc->p_exitStatus = a2_status;
                 terminate_process(a1_pid); 
             }
             if (current_p == NULL) 
@@ -139,6 +146,13 @@ void syscall_handler() {
         case YIELD:
             yield(&block_flag, &low_priority);
             break; 
+        case WAITCHILD:
+            {
+                int *a1_status = (int *) exception_state->reg_a1;
+                int a2_options = exception_state->reg_a2;
+                wait_child(a1_status, a2_options, &block_flag);
+            }
+            break; 
         default:
             pass_up_or_die(GENERALEXCEPT, exception_state); 
             break; 
@@ -161,6 +175,8 @@ void syscall_handler() {
             STCK(start_usage_cpu); 
             // Il nuovo processo da eseguire è un processo a bassa priorità
             current_p = removeProcQ(&(ready_lq));                               
+            // Come nello scheduler, le pagine piu' usate del processo vengono caricate nel TLB prima di eseguirlo
+            tlb_preload(current_p->p_s.entry_hi);
             // Aggiornamento dello status register del processore al nuovo stato del nuovo current_p
             LDST(&(current_p->p_s));                                            
         }
@@ -180,9 +196,10 @@ void create_process(state_t *a1_state, int a2_p_prio, support_t *a3_p_support_st
         copy_state(&(new_proc->p_s), a1_state); 
         new_proc->p_prio = a2_p_prio; 
         new_proc->p_supportStruct = a3_p_support_struct; 
+        // Solo un processo in kernel mode puo' chiamare WAITCHILD: i figli terminati degli altri vengono liberati subito
+        new_proc->p_reaper = !(a1_state->status & USERPON);
 
-        // PID è implementato come l'indirizzo del pcb_t
-        new_proc->p_pid = (int) new_proc;                           
+        // Il PID, validato tramite la tabella dei PID, e' assegnato da allocPcb
         p_count++; 
         ready_by_priority(new_proc); 
         // Operazione completata, ritorno con successo
@@ -195,19 +212,16 @@ void create_process(state_t *a1_state, int a2_p_prio, support_t *a3_p_support_st
 // NSYS2
 void terminate_process(int a1_pid) {
     pcb_PTR old_proc; 
+    // La rimozione dalla lista dei figli del padre avviene in terminate_all, che notifica il padre
     if (a1_pid == 0) {
-        // Rimozione di current_p dalla lista dei figli del suo padre
-        outChild(current_p);                                
         if (current_p != NULL) 
             // Terminazione di tutta la discendenza di current_p
             terminate_all(current_p);                       
         // Terminazione del processo corrente
         current_p = NULL;                                    
     } else {
-        // PID è implementato come indirizzo del PCB
-        old_proc = (pcb_PTR) a1_pid;                        
-        // Rimozione di old_proc dalla lista dei figli del suo padre
-        outChild(old_proc);                                 
+        // Un PID non valido o di un processo gia' terminato (anche con lo slot riutilizzato) viene ignorato
+        old_proc = pid_lookup(a1_pid);                        
         if (old_proc != NULL) 
             // Terminazione di tutta la discendenza di old_proc
             terminate_all(old_proc);      
@@ -216,35 +230,97 @@ void terminate_process(int a1_pid) {
     }
 }
 
-// Funzione ausiliaria ricorsiva che termina l'intera discendenza del processo old_proc (incluso old_proc)
+/*
+    Scrive PID e stato di uscita del figlio terminato child nello stato state del padre, e libera il pcb del figlio.
+    Il padre deve essere il processo corrente: a1 e' un indirizzo del suo address space, risolto tramite il suo ASID.
+*/
+HIDDEN void collect_child(pcb_PTR child, state_t *state) {
+    int *status = (int *) state->reg_a1;
+    if (status != NULL)
+        *status = child->p_exitStatus;
+    state->reg_v0 = child->p_pid;
+    freePcb(child);
+}
+
+// Consegna il figlio terminato child al padre parent tramite la coda di completamento, risvegliandolo se e' bloccato in WAITCHILD
+HIDDEN void child_done(pcb_PTR parent, pcb_PTR child) {
+    list_add_tail(&(child->p_list), &(parent->p_done));
+    if (headBlocked(&(parent->p_waitSem)) != NULL) {
+        /*
+            Il processo corrente non e' il padre, quindi lo stato di uscita non puo' essere scritto ora in *a1.
+            Il PC salvato al momento del blocco viene riportato sulla SYSCALL: il padre la riesegue e raccoglie il figlio.
+        */
+        removeBlocked(&(parent->p_waitSem));
+        parent->p_semAdd = NULL;
+        parent->p_s.pc_epc -= WORDLEN;
+        ready_by_priority(parent);
+    }
+}
+
+// Rimuove da code e semafori il singolo processo old_proc, i cui figli sono gia' stati terminati
+HIDDEN void terminate_one(pcb_PTR old_proc) {
+    pcb_PTR child;
+
+    // I figli gia' terminati e non ancora raccolti non hanno piu' un padre che possa raccoglierli
+    while (!list_empty(&(old_proc->p_done))) {
+        child = container_of(old_proc->p_done.next, pcb_t, p_list);
+        list_del(&(child->p_list));
+        freePcb(child);
+    }
+    if (old_proc == current_p)
+        current_p = NULL; 
+
+    // Aggiornamento semafori / variabile di conteggio dei bloccati su I/O
+    if (old_proc->p_semAdd != NULL) {
+        if ((old_proc->p_semAdd >= &(sem[0])) && (old_proc->p_semAdd <= &(sem[DEVICE_INITIAL])))
+            soft_counter -= 1;
+        outBlocked(old_proc); 
+    }
+    // Rimozione in O(1): se il processo non e' in una ready queue outProcQ non fa nulla
+    switch (old_proc->p_prio) {
+        case PROCESS_PRIO_LOW:
+            outProcQ(&(ready_lq), old_proc);
+            break;
+        default:
+            outProcQ(&(ready_hq), old_proc);
+            break;
+    }
+    p_count -= 1;
+    // Il PID non e' piu' valido, ma resta in p_pid per essere consegnato al padre da WAITCHILD
+    pid_release(old_proc);
+}
+
+/*
+    Termina l'intera discendenza del processo old_proc (incluso old_proc) senza ricorsione, quindi con uno spazio
+    costante sullo stack del nucleo qualunque sia la profondita' dell'albero: la lista di lavoro e' l'albero stesso,
+    percorso scendendo lungo il primo figlio e risalendo tramite p_parent dopo aver terminato ogni foglia.
+*/
 void terminate_all(pcb_PTR old_proc) {
     if (old_proc != NULL) {
-        pcb_PTR child;   
-        
-        // Task di terminazione di un processo (sezione 3.9, manuale pandosplus)
-        while((child = removeChild(old_proc)) != NULL){      
-            if (child == current_p)
-                current_p = NULL; 
-            terminate_all(child); 
-        }
+        // Solo la radice della discendenza conserva il padre, che non viene terminato
+        pcb_PTR parent = old_proc->p_parent;
+        outChild(old_proc);
 
-        // Aggiornamento semafori / variabile di conteggio dei bloccati su I/O
-        if (old_proc->p_semAdd != NULL) {
-            if ((old_proc->p_semAdd >= &(sem[0])) && (old_proc->p_semAdd <= &(sem[DEVICE_INITIAL])))
-                soft_counter -= 1;
-            outBlocked(old_proc); 
-        }
-        switch (old_proc->p_prio) {
-            case PROCESS_PRIO_LOW:
-                outProcQ(&(ready_lq), old_proc);
-                break;
-            default:
-                outProcQ(&(ready_hq), old_proc);
-                break;
+        // Task di terminazione di un processo (sezione 3.9, manuale pandosplus)
+        pcb_PTR iter = old_proc;
+        while (iter != NULL) {
+            if (!emptyChild(iter)) {
+                // Si scende nel primo figlio: i figli vengono terminati prima del padre
+                iter = container_of(iter->p_child.next, pcb_t, p_sib);
+                continue;
+            }
+            // iter non ha figli: viene staccato dal padre e terminato, poi si risale
+            pcb_PTR next = (iter == old_proc) ? NULL : iter->p_parent;
+            outChild(iter);
+            terminate_one(iter);
+            if (iter == old_proc && parent != NULL && parent->p_reaper)
+                // old_proc resta nella coda di completamento del padre finche' non viene raccolto con WAITCHILD
+                child_done(parent, old_proc);
+            else
+                // Inserimento nella lista dei pcb liberi da allocare
+                freePcb(iter);
+            iter = next;
         }
-        p_count -= 1;
-        // Inserimento di old_proc nella lista dei pcb liberi da allocare
-        freePcb(old_proc);                                  
     }
 }
 
@@ -331,9 +407,9 @@ void get_support_data() {
 // NSYS9
 void get_processor_id(int a1_parent) {
     if (a1_parent == 0)
-        exception_state->reg_v0 = (unsigned int) current_p;
+        exception_state->reg_v0 = current_p->p_pid;
     else
-        exception_state->reg_v0 = (unsigned int) current_p->p_parent;
+        exception_state->reg_v0 = (current_p->p_parent != NULL) ? current_p->p_parent->p_pid : 0;
 }
 
 // NSYS10
@@ -365,10 +441,31 @@ void yield(int *block_flag, int *low_priority) {
     }
 }
 
+// NSYS11
+void wait_child(int *a1_status, int a2_options, int *block_flag) {
+    if (!list_empty(&(current_p->p_done))) {
+        // Raccolta in O(1) del primo figlio terminato
+        pcb_PTR child = container_of(current_p->p_done.next, pcb_t, p_list);
+        list_del(&(child->p_list));
+        collect_child(child, exception_state);
+    } else if (emptyChild(current_p))
+        // Nessun figlio da attendere
+        exception_state->reg_v0 = NOPROC;
+    else if (a2_options & WAITNOHANG)
+        exception_state->reg_v0 = 0;
+    else {
+        // Il processo viene sbloccato da child_done alla terminazione di uno dei figli, e riesegue la SYSCALL
+        if (insertBlocked(&(current_p->p_waitSem), current_p))
+            PANIC();
+        *block_flag = 1;
+    }
+}
+
 // Program Trap handler & TLB Exception handler
 void pass_up_or_die(int index_value, state_t* exception_state) {
     // Se il processo non ha specificato un modo per gestire l'eccezione, viene terminato
     if (current_p->p_supportStruct == NULL) {           
+        current_p->p_exitStatus = KILLEDSTATUS;
         terminate_process(0);
         current_p = NULL; 
         scheduler(); 
@@ -401,18 +498,8 @@ void uTLB_RefillHandler() {
     // Recupero dello stato al momento dell'eccezione del processore
     exception_state = (state_t *) BIOSDATAPAGE;
 
-    // Recupero del numero di pagina che non si trova nel TLB
-    int page_missing = (exception_state->entry_hi - KUSEG) >> VPNSHIFT; 
-
-    // Per convenzione, la pagina dello stack e' settata a 0xBFFFF
-    if ((exception_state->entry_hi >> VPNSHIFT) == 0xBFFFF)
-        // Si tratta della pagina dello stack
-        page_missing = MAXPAGES - 1;
-
-    // Scrittura della entry in TLB
-    setENTRYHI(current_p->p_supportStruct->sup_privatePgTbl[page_missing].pte_entryHI);
-    setENTRYLO(current_p->p_supportStruct->sup_privatePgTbl[page_missing].pte_entryLO);
-    TLBWR();
+    // Scrittura in TLB della entry, tramite la cache software delle traduzioni recenti
+    tlb_refill(current_p->p_supportStruct, exception_state->entry_hi);
 
     // Riprova l'ultima istruzione che ha causato l'eccezione TLB-Refill
     LDST(exception_state);
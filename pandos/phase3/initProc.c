@@ -13,61 +13,65 @@ int printer_sem[UPROCMAX],
 // Semaforo per non terminare test prima che tutti gli U-proc siano terminati
 int block_sem;
 
-// Semaforo per aspettare la terminazione dei processi creati da test. 
-int master_semaphore; 
+// Per ogni slot: SLOTFREE se libero, NOPROC se il U-proc e' stato creato da test, altrimenti l'indice del padre
+int uproc_parent[UPROCMAX];
+// Per ogni slot: PID del processo del nucleo che esegue l'U-proc, NOPROC se non ancora creato
+int uproc_pid[UPROCMAX];
 
 extern void general_exception_handler();
 extern void pager();
+extern int swap_pool_semaphore;
 
 void test(){
-    //Inizializzazione del master_semaphore
-    master_semaphore = 0; 
-    // Inizializzazione strutture dati della memoria virtuale
-    initSwapStructs();
-    // Inizializzazione dei semafori dei device
+    // Inizializzazione dei semafori dei device, usati anche da initSwapStructs per leggere gli header delle immagini
     for (int i = 0; i < UPROCMAX; i++){
         printer_sem[i] = 1;
         tread_sem[i] = 1;
         twrite_sem[i] = 1;
         flash_sem[i] = 1;
     }
+    // Inizializzazione strutture dati della memoria virtuale
+    initSwapStructs();
+    initASID();
+    init_uproc_pool();
 
-    // Ciclo di inizializzazione dei processi utente
     for (int i = 0; i < UPROCMAX; i++){
-        // Il PC e il registro t9 devono essere inizializzati all'inizio della sezione .text 
-        uproc_state[i].pc_epc = (uproc_state[i].reg_t9 = UPROCSTARTADDR);
-
-        
-        // Inizializzazione dello stack pointer
-        uproc_state[i].reg_sp = USERSTACKTOP;
-
-        /* 
-            Quando si verifica un interrupt della linea i, se gli interrupt sono abilitati,
-            il processore accetta l'interrupt solo se il bit Status.IM[i] e' acceso.
-            IMON accende tutti i Status.IM.
-            USERPON disattiva la kernel mode, settando il bit KUp a 1. E' necessario settare KUp e non KUc
-            perche' al momento in cui si verifica un'eccezione il bit KUc viene mosso in KUp, e KUc viene posto a 0.
-            Quando viene effettutata una operazione di LDST, avviene un'operazione complementare,
-            per cui per disattivare la kernel mode, basta porre KUp a 1.
-            Discorso analogo per IEp/IEc, la cui funzione e' quella di attivare / disattivare gli interrupt.
-        */
-        uproc_state[i].status = TEBITON | IMON | USERPON | IEPON;
-        uproc_state[i].entry_hi = (i + 1) << ASIDSHIFT;
+        uproc_parent[i] = SLOTFREE;
+        uproc_pid[i] = NOPROC;
+    }
+    // load_uproc va eseguita in mutua esclusione sulla swap pool
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0);
+    // Ciclo di inizializzazione dei processi utente: al boot ogni flash device contiene l'immagine di un U-proc
+    for (int i = 0; i < UPROCMAX; i++){
+        int slot = load_uproc(i, NOPROC);
+        // NSYS1
+        if (slot == -1 || start_uproc(slot) < 0){
+            // Termina il processo di test, non e' stato possibile creare un processo
+            SYSCALL(TERMINATE, 0, 0, 0);
+        }
+    }
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0);
+    /*
+        Raccolta degli U-proc creati da test man mano che terminano: la terminazione di un U-proc termina anche
+        i figli creati con FORK o SPAWN, quindi quando test non ha piu' figli non ci sono piu' U-proc vivi.
+    */
+    while (SYSCALL(WAITCHILD, 0, 0, 0) != NOPROC)
+        ;
+    SYSCALL(TERMPROCESS, 0, 0, 0);
+}
 
-        // Ad ogni processo utente deve essere assegnato un asid di valore strettamente positivo e unico
-        uproc_support[i].sup_asid = i + 1;
+void init_uproc_pool(){
+    // Ricavo del RAMTOP
+    memaddr ram_top; 
+    RAMTOP(ram_top);
 
+    for (int i = 0; i < UPROCMAX; i++){
         // Inizializzazione dei campi PC usati dal nucleo per passare la gestione al livello di supporto.
         uproc_support[i].sup_exceptContext[GENERALEXCEPT].pc = (memaddr) general_exception_handler;
         uproc_support[i].sup_exceptContext[PGFAULTEXCEPT].pc = (memaddr) pager;
         // Modalita' kernel accesa (bit KUp a 0), interrupt abilitati e PLT abilitato
         uproc_support[i].sup_exceptContext[GENERALEXCEPT].status = IMON | IEPON | TEBITON;
         uproc_support[i].sup_exceptContext[PGFAULTEXCEPT].status = IMON | IEPON | TEBITON;
-
-        // Ricavo del RAMTOP
-        memaddr ram_top; 
-        RAMTOP(ram_top);
-
         /* 
             Inizializzazione degli stack utilizzati dal pager e dal general exception handler. 
             Come raccomandato dal manuale di pandosplus, e' utilizzata la RAM strettamente al di sotto
@@ -75,27 +79,77 @@ void test(){
         */
         uproc_support[i].sup_exceptContext[PGFAULTEXCEPT].stackPtr = (memaddr) (ram_top - (i + 1) * PAGESIZE * 2);
         uproc_support[i].sup_exceptContext[GENERALEXCEPT].stackPtr = (memaddr) (ram_top - (i + 1) * PAGESIZE * 2 + PAGESIZE);
-        // Ciclo di inizializzazione della page table degli u-proc
-        for (int j = 0; j < MAXPAGES; j++){
-            if (j == MAXPAGES - 1)
-                // L'ultima pagina e' la pagina di stack, il VPN deve essere settato a 0xBFFFF
-                uproc_support[i].sup_privatePgTbl[j].pte_entryHI = 0xBFFFF << VPNSHIFT;
-            else
-                // Inizializzazione della VPN, campo della entryHI che comincia dal bit VPNSHIFT
-                uproc_support[i].sup_privatePgTbl[j].pte_entryHI = KUSEG + (j << VPNSHIFT);
-            // Inizializzazione dell'asid, campo della entryHI che comincia dal bit ASIDSHIFT
-            uproc_support[i].sup_privatePgTbl[j].pte_entryHI |= (uproc_support[i].sup_asid) << ASIDSHIFT;
-            // La pagina non si trova in memoria quindi basta porre i bit V a 0, D a 1 (protezione della memoria disattivata)
-            uproc_support[i].sup_privatePgTbl[j].pte_entryLO = DIRTYON;
-        }
+        // La page table e' vuota; alla terminazione free_pgtable la riporta in questo stato, senza doverla reinizializzare
+        init_pgtable(&uproc_support[i]);
+    }
+}
 
-        // NSYS1
-        if (SYSCALL(CREATEPROCESS, (memaddr) &uproc_state[i], PROCESS_PRIO_LOW, (memaddr) &uproc_support[i]) < 0){
-            // Termina il processo di test, non e' stato possibile creare un processo
-            SYSCALL(TERMINATE, 0, 0, 0);
-        }
+support_t *init_uproc_support(int i){
+    // Ad ogni processo utente deve essere assegnato un asid di valore strettamente positivo e unico
+    uproc_support[i].sup_asid = i + 1;
+    // L'ASID hardware, usato nel TLB, e' assegnato dall'allocatore e cambia ogni volta che lo slot viene riusato
+    uproc_support[i].sup_tlbAsid = alloc_asid(i);
+    // Contesti, stack e page table vuota sono gia' pronti dal boot (init_uproc_pool)
+    return &uproc_support[i];
+}
+
+int load_uproc(int dev, int parent){
+    int i = alloc_uproc_slot(parent);
+    if (i == -1)
+        return -1;
+
+    // Il PC e il registro t9 devono essere inizializzati all'inizio della sezione .text 
+    uproc_state[i].pc_epc = (uproc_state[i].reg_t9 = UPROCSTARTADDR);
+    // Inizializzazione dello stack pointer
+    uproc_state[i].reg_sp = USERSTACKTOP;
+    /* 
+        Quando si verifica un interrupt della linea i, se gli interrupt sono abilitati,
+        il processore accetta l'interrupt solo se il bit Status.IM[i] e' acceso.
+        IMON accende tutti i Status.IM.
+        USERPON disattiva la kernel mode, settando il bit KUp a 1. E' necessario settare KUp e non KUc
+        perche' al momento in cui si verifica un'eccezione il bit KUc viene mosso in KUp, e KUc viene posto a 0.
+        Quando viene effettutata una operazione di LDST, avviene un'operazione complementare,
+        per cui per disattivare la kernel mode, basta porre KUp a 1.
+        Discorso analogo per IEp/IEc, la cui funzione e' quella di attivare / disattivare gli interrupt.
+    */
+    uproc_state[i].status = TEBITON | IMON | USERPON | IEPON;
+    init_uproc_support(i);
+    uproc_state[i].entry_hi = uproc_support[i].sup_tlbAsid << ASIDSHIFT;
+
+    if (vm_load(&uproc_support[i], dev) == -1){
+        // Il device non contiene un'immagine aout eseguibile
+        release_uproc(i);
+        return -1;
+    }
+#if LAUNCHPRELOAD
+    // La prima pagina di .text (che contiene l'header) e la pagina di stack sono pronte prima della prima istruzione
+    if (vm_preload(&uproc_support[i]) == -1){
+        // L'immagine non e' leggibile: lo slot preparato a meta' viene rilasciato
+        release_uproc(i);
+        return -1;
     }
+#endif
+    return i;
+}
+
+int start_uproc(int i){
+    int pid = SYSCALL(CREATEPROCESS, (memaddr) &uproc_state[i], PROCESS_PRIO_LOW, (memaddr) &uproc_support[i]);
+    // Il PID serve per eliminare l'U-proc dal nucleo prima di rilasciarne le risorse, se termina un suo antenato
+    if (pid >= 0)
+        uproc_pid[i] = pid;
+    return pid;
+}
+
+int alloc_uproc_slot(int parent){
     for (int i = 0; i < UPROCMAX; i++)
-        SYSCALL(PASSEREN, (memaddr) &master_semaphore, 0, 0);
-    SYSCALL(TERMPROCESS, 0, 0, 0);
-}
\ No newline at end of file
+        if (uproc_parent[i] == SLOTFREE){
+            uproc_parent[i] = parent;
+            uproc_pid[i] = NOPROC;
+            // Il semaforo di un device potrebbe essere rimasto acquisito dal precedente proprietario dello slot
+            printer_sem[i] = 1;
+            tread_sem[i] = 1;
+            twrite_sem[i] = 1;
+            return i;
+        }
+    return -1;
+}
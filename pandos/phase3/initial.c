@@ -2,6 +2,7 @@
 
 extern void test();
 extern void uTLB_RefillHandler();
+extern void initTLB();
 extern void exception_handler();
 extern void scheduler();
 
@@ -42,6 +43,8 @@ int main () {
     // Inizializzazione delle strutture dati di fase 1
     initPcbs();
     initASL();
+    // Inizializzazione della cache software delle traduzioni usata dal TLB-Refill handler
+    initTLB();
 
     // Interval timer di 100 ms (in microseconds)
 	LDIT(100000);
@@ -60,6 +63,8 @@ int main () {
 
         */ 
     (new_p->p_s).status = TEBITON | IEPON | IMON;
+    // test raccoglie i propri figli con WAITCHILD, anche quelli che terminano prima della prima chiamata
+    new_p->p_reaper = TRUE;
     
     // Inizializzazione sp a RAMTOP, i.e. lo stack dedicato a tale processo e' l'ultimo frame della RAM. 
     RAMTOP((new_p->p_s).reg_sp);
@@ -4,16 +4,25 @@
 HIDDEN LIST_HEAD(pcbFree_h);            
 // Tabella contenente tutti i PCB
 HIDDEN pcb_t pcbFree_table[MAXPROC];    
+// Generazione corrente di ogni slot della pcbFree_table, incrementata ad ogni allocazione
+HIDDEN int pid_gen[MAXPROC];
+// PID del processo vivo in ogni slot, 0 se il pcb e' libero o il processo e' terminato
+HIDDEN int pid_table[MAXPROC];
 
 void initPcbs() {
-    for (int i = 0; i < MAXPROC; i++)                                       
+    for (int i = 0; i < MAXPROC; i++) {
+        pid_gen[i] = 0;
+        pid_table[i] = 0;
         // Inserisce i p_list in pcbFree_h
         list_add_tail(&(pcbFree_table[i].p_list), &pcbFree_h);              
+    }
 }
 
 void freePcb(pcb_t* p) {
-    if (p != NULL)
+    if (p != NULL) {
+        pid_release(p);
         list_add_tail(&(p->p_list), &pcbFree_h);
+    }
 }
 
 pcb_t* allocPcb() {
@@ -28,6 +37,7 @@ pcb_t* allocPcb() {
         INIT_LIST_HEAD(&(newPcb->p_list));                                  
         INIT_LIST_HEAD(&(newPcb->p_child));
         INIT_LIST_HEAD(&(newPcb->p_sib));
+        INIT_LIST_HEAD(&(newPcb->p_done));
 
         newPcb->p_parent = NULL;
         newPcb->p_semAdd = NULL;
@@ -45,8 +55,16 @@ pcb_t* allocPcb() {
         
         // Inizializzazione dei campi rimantenti
         newPcb->p_prio = 0;                                                 
-        newPcb->p_pid = 0;
+        // Il PID combina lo slot e una nuova generazione, quindi e' diverso da quello dei processi che hanno usato lo slot in precedenza
+        int slot = newPcb - pcbFree_table;
+        pid_gen[slot] = pid_gen[slot] % PIDGENMAX + 1;
+        newPcb->p_pid = (pid_gen[slot] << PIDSHIFT) | (slot + 1);
+        pid_table[slot] = newPcb->p_pid;
         newPcb->p_supportStruct = NULL; 
+        // I figli terminati vengono liberati subito, a meno che il processo non sia creato in kernel mode (create_process)
+        newPcb->p_waitSem = 0;
+        newPcb->p_reaper = FALSE;
+        newPcb->p_exitStatus = 0;
 
         return newPcb;
     }
@@ -78,26 +96,20 @@ pcb_t* removeProcQ(struct list_head* head) {
     else {
         pcb_t* oldestPcb = container_of(head->next, pcb_t, p_list);
         list_del(head->next);
+        // Un p_list vuoto indica che il PCB non si trova in nessuna coda
+        INIT_LIST_HEAD(&(oldestPcb->p_list));
         return oldestPcb;
     }
 }
 
 pcb_t* outProcQ(struct list_head* head, pcb_t* p) {
-    if (list_empty(head))
+    // p non si trova in nessuna coda (e quindi nemmeno in head)
+    if (list_empty(head) || list_empty(&(p->p_list)))
         return NULL;
-    else {
-        pcb_t* iter;
-        // Per ogni PCB della coda dei processi head
-        list_for_each_entry(iter, head, p_list) {                       
-            if (iter == p) {
-                // Rimozione di p da head
-                list_del(&(p->p_list));                                 
-                return p;
-            }
-        }
-        // Caso in cui non venga trovato p in head
-        return NULL;                                                    
-    }
+    // Rimozione di p da head in O(1), senza scorrere la coda
+    list_del(&(p->p_list));
+    INIT_LIST_HEAD(&(p->p_list));
+    return p;
 }
 
 int emptyChild(pcb_t* p) {
@@ -147,4 +159,16 @@ void copy_state(state_t *a, state_t *b) {
         a->gpr[i] = b->gpr[i];
     a->hi = b->hi;
     a->lo = b->lo;
-}
\ No newline at end of file
+}
+
+pcb_t* pid_lookup(int pid) {
+    int slot = (pid & PIDINDEXMASK) - 1;
+    // Un PID e' valido solo se coincide con quello del processo vivo nel suo slot
+    if (pid <= 0 || slot < 0 || slot >= MAXPROC || pid_table[slot] != pid)
+        return NULL;
+    return &pcbFree_table[slot];
+}
+
+void pid_release(pcb_t* p) {
+    pid_table[p - pcbFree_table] = 0;
+}
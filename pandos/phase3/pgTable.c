@@ -0,0 +1,211 @@
+#include "../h/pgTable.h"
+#include "../h/vmSupport.h"
+
+extern swap_t *swap_pool;
+extern memaddr swap_pool_start;
+extern pteEntry_t shared_pgTbl[SHAREDPAGES];
+
+#if PGTABLEMODE == PGINVERTED
+// Page table invertita: le entry di tutti i processi, allocate all'avvio in proporzione alla swap pool
+HIDDEN ipt_t *ipt;
+HIDDEN int ipt_entries;
+// Tabella hash delle entry allocate, indicizzata per (ASID, VPN), e lista delle entry libere
+HIDDEN struct list_head ipt_hash[IPTBUCKETS];
+HIDDEN LIST_HEAD(ipt_free_h);
+
+// Bucket della tabella hash che contiene la entry di entry_hi
+#define IPTHASH(entry_hi) ((((entry_hi) >> VPNSHIFT) * 7 + ENTRYHI_GET_ASID(entry_hi)) % IPTBUCKETS)
+// VPN e ASID di entry_hi, confrontati durante la ricerca
+#define IPTKEY(entry_hi) ((entry_hi) & (~(PAGESIZE - 1) | ENTRYHI_ASID_MASK))
+
+// Restituisce la entry alla lista delle entry libere
+HIDDEN void ipt_release(ipt_t *entry){
+	// Il TLB-Refill handler potrebbe scorrere il bucket nel frattempo
+	setSTATUS(getSTATUS() & DISABLEINTS);
+	list_del(&(entry->ipt_list));
+	setSTATUS(getSTATUS() | IECON);
+	entry->ipt_pte.pte_entryHI = 0;
+	list_add_tail(&(entry->ipt_list), &ipt_free_h);
+}
+
+/*
+	Libera le entry non valide di pagine che non occupano un frame e non hanno una copia in memoria secondaria:
+	al prossimo accesso il pager le ricostruisce dall'immagine o le azzera, quindi non contengono informazioni.
+*/
+HIDDEN void ipt_reclaim(){
+	for (int i = 0; i < ipt_entries; i++){
+		pteEntry_t *pte = &(ipt[i].ipt_pte);
+		if (pte->pte_entryHI == 0 || (pte->pte_entryLO & VALIDON))
+			continue;
+		int frame = pfn_frame(pte->pte_entryLO);
+		if (frame != -1 && swap_pool[frame].sw_pte == pte)
+			continue;
+		int asid = asid_slot(ENTRYHI_GET_ASID(pte->pte_entryHI)), page = KUSEGPAGE(pte->pte_entryHI), dev;
+		if (asid == -1 || zswap_contains(asid, page) || swap_slot(asid, page, &dev) != -1)
+			continue;
+		stlb_remove(pte->pte_entryHI);
+		ipt_release(&ipt[i]);
+	}
+}
+#endif
+
+void initPgTable(ipt_t *start, int entries){
+#if PGTABLEMODE == PGINVERTED
+	ipt = start;
+	ipt_entries = entries;
+	INIT_LIST_HEAD(&ipt_free_h);
+	for (int i = 0; i < IPTBUCKETS; i++)
+		INIT_LIST_HEAD(&ipt_hash[i]);
+	for (int i = 0; i < entries; i++){
+		ipt[i].ipt_pte.pte_entryHI = 0;
+		list_add_tail(&(ipt[i].ipt_list), &ipt_free_h);
+	}
+#endif
+}
+
+void init_pgtable(support_t *curr_support){
+#if PGTABLEMODE == PGTWOLEVEL
+	// Le tabelle di secondo livello vengono allocate dal pager al primo accesso
+	for (int i = 0; i < PGDIRSIZE; i++)
+		curr_support->sup_pgDir[i] = NULL;
+#endif
+}
+
+int legal_address(unsigned int entry_hi){
+	if ((entry_hi >> SHAREDSEGFLAG) == SHARED)
+		return ((entry_hi & GETPAGENO) >> VPNSHIFT) < SHAREDPAGES;
+	return entry_hi >= KUSEG;
+}
+
+pteEntry_t *get_pte(support_t *curr_support, unsigned int entry_hi){
+	if (!legal_address(entry_hi))
+		return NULL;
+	if ((entry_hi >> SHAREDSEGFLAG) == SHARED)
+		// Segmento condiviso KUSEG3
+		return &shared_pgTbl[(entry_hi & GETPAGENO) >> VPNSHIFT];
+	// Due soli accessi in memoria (directory e tabella di secondo livello) o la ricerca in un bucket della tabella hash
+	return page_pte(curr_support, KUSEGPAGE(entry_hi));
+}
+
+int pte_frames(support_t *curr_support, unsigned int entry_hi){
+	if (get_pte(curr_support, entry_hi) != NULL)
+		return 0;
+#if PGTABLEMODE == PGTWOLEVEL
+	// Serve un frame per la tabella di secondo livello
+	return 1;
+#else
+	if (list_empty(&ipt_free_h))
+		ipt_reclaim();
+	return list_empty(&ipt_free_h) ? -1 : 0;
+#endif
+}
+
+#if PGTABLEMODE == PGTWOLEVEL
+pteEntry_t *page_pte(support_t *curr_support, int page){
+	pteEntry_t *table = curr_support->sup_pgDir[page / PGTBLSIZE];
+	if (table == NULL)
+		return NULL;
+	return &table[page % PGTBLSIZE];
+}
+
+pteEntry_t *alloc_pte(support_t *curr_support, unsigned int entry_hi){
+	pteEntry_t *pte = get_pte(curr_support, entry_hi);
+	if (pte != NULL || !legal_address(entry_hi))
+		return pte;
+
+	// La tabella di secondo livello occupa un frame della swap pool, bloccato in memoria finche' il processo non termina
+	int dir = KUSEGPAGE(entry_hi) / PGTBLSIZE;
+	int frame = get_frame(curr_support);
+	swap_pool[frame].sw_asid = PGTABLE;
+	swap_pool[frame].sw_pageNo = dir;
+	swap_pool[frame].sw_flags = 0;
+	pin_frame(frame);
+
+	pteEntry_t *table = (pteEntry_t *) FRAMEADDR(frame);
+	for (int i = 0; i < PGTBLSIZE; i++){
+		// Inizializzazione della VPN e dell'ASID; la pagina non e' in memoria: V a 0, D a 1 (protezione della memoria disattivata)
+		table[i].pte_entryHI = PAGEADDR(dir * PGTBLSIZE + i) | (curr_support->sup_tlbAsid << ASIDSHIFT);
+		table[i].pte_entryLO = DIRTYON;
+	}
+	// La tabella diventa visibile al TLB-Refill handler solo dopo essere stata inizializzata
+	curr_support->sup_pgDir[dir] = table;
+	return &table[KUSEGPAGE(entry_hi) % PGTBLSIZE];
+}
+
+pteEntry_t *next_pte(support_t *curr_support, int *cursor){
+	// Il cursore e' l'indice della prossima pagina di KUSEG da esaminare
+	while (*cursor < KUSEGPAGES){
+		pteEntry_t *table = curr_support->sup_pgDir[*cursor / PGTBLSIZE];
+		if (table == NULL){
+			// Le parti dell'address space mai toccate vengono saltate per intero
+			*cursor += PGTBLSIZE - (*cursor % PGTBLSIZE);
+			continue;
+		}
+		return &table[(*cursor)++ % PGTBLSIZE];
+	}
+	return NULL;
+}
+
+void free_pgtable(support_t *curr_support){
+	for (int dir = 0; dir < PGDIRSIZE; dir++){
+		pteEntry_t *table = curr_support->sup_pgDir[dir];
+		if (table == NULL)
+			continue;
+		curr_support->sup_pgDir[dir] = NULL;
+		int frame = pfn_frame((memaddr) table);
+		unpin_frame(frame);
+		swap_pool[frame].sw_asid = NOPROC;
+		swap_pool[frame].sw_flags = 0;
+		release_frame(frame);
+	}
+}
+#else
+pteEntry_t *page_pte(support_t *curr_support, int page){
+	unsigned int key = PAGEADDR(page) | (curr_support->sup_tlbAsid << ASIDSHIFT);
+	ipt_t *iter;
+	list_for_each_entry(iter, &ipt_hash[IPTHASH(key)], ipt_list)
+		if (IPTKEY(iter->ipt_pte.pte_entryHI) == key)
+			return &(iter->ipt_pte);
+	return NULL;
+}
+
+pteEntry_t *alloc_pte(support_t *curr_support, unsigned int entry_hi){
+	pteEntry_t *pte = get_pte(curr_support, entry_hi);
+	if (pte != NULL || !legal_address(entry_hi))
+		return pte;
+
+	if (list_empty(&ipt_free_h))
+		ipt_reclaim();
+	// Tutte le entry descrivono pagine in memoria o salvate, la pagina non puo' essere tracciata
+	if (list_empty(&ipt_free_h))
+		terminate(curr_support->sup_asid - 1);
+
+	ipt_t *entry = container_of(ipt_free_h.next, ipt_t, ipt_list);
+	list_del(&(entry->ipt_list));
+	// La pagina non e' in memoria: V a 0, D a 1 (protezione della memoria disattivata)
+	entry->ipt_pte.pte_entryHI = PAGEADDR(KUSEGPAGE(entry_hi)) | (curr_support->sup_tlbAsid << ASIDSHIFT);
+	entry->ipt_pte.pte_entryLO = DIRTYON;
+
+	// La entry diventa visibile al TLB-Refill handler solo dopo essere stata inizializzata
+	setSTATUS(getSTATUS() & DISABLEINTS);
+	list_add(&(entry->ipt_list), &ipt_hash[IPTHASH(entry->ipt_pte.pte_entryHI)]);
+	setSTATUS(getSTATUS() | IECON);
+	return &(entry->ipt_pte);
+}
+
+pteEntry_t *next_pte(support_t *curr_support, int *cursor){
+	// Il cursore e' l'indice della prossima entry della page table invertita da esaminare
+	while (*cursor < ipt_entries){
+		pteEntry_t *pte = &(ipt[(*cursor)++].ipt_pte);
+		if (pte->pte_entryHI != 0 && ENTRYHI_GET_ASID(pte->pte_entryHI) == curr_support->sup_tlbAsid)
+			return pte;
+	}
+	return NULL;
+}
+
+void free_pgtable(support_t *curr_support){
+	for (int i = 0; i < ipt_entries; i++)
+		if (ipt[i].ipt_pte.pte_entryHI != 0 && ENTRYHI_GET_ASID(ipt[i].ipt_pte.pte_entryHI) == curr_support->sup_tlbAsid)
+			ipt_release(&ipt[i]);
+}
+#endif
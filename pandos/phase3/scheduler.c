@@ -9,6 +9,7 @@ extern int p_count;
 extern int soft_counter; 
 
 cpu_t start_usage_cpu;
+extern void tlb_preload(unsigned int entry_hi);
 
 void scheduler() {
     pcb_PTR HP_pcb = headProcQ(&(ready_hq));
@@ -23,12 +24,15 @@ void scheduler() {
     if (HP_pcb != NULL) {                                       
         // Se ci sono dei processi ad alta priorita' in stato ready
         current_p = removeProcQ(&(ready_hq));                       
+        // Le pagine piu' usate del processo vengono caricate nel TLB, evitando una serie di refill
+        tlb_preload(current_p->p_s.entry_hi);
         LDST(&(current_p->p_s));
         // Tempo di inizio di uso della CPU
         STCK(start_usage_cpu);                                      
     } else if (HP_pcb == NULL && LP_pcb != NULL) {               
         // Se vi sono solo processi a bassa priorita' 
         current_p = removeProcQ(&(ready_lq));
+        tlb_preload(current_p->p_s.entry_hi);
         setTIMER(TIMESLICE);
         // Tempo di inizio di uso della CPU
         STCK(start_usage_cpu); 
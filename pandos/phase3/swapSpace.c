@@ -0,0 +1,245 @@
+#include "../h/swapSpace.h"
+#include "../h/vmSupport.h"
+
+extern memaddr swap_pool_start;
+
+// Blocchi iniziali occupati dall'immagine aout su ciascun flash device e sul disco (indice MMAPDISK)
+HIDDEN int image_area[DEVPERINT + 1];
+// Numero di swap slot disponibili su ciascun flash device
+HIDDEN int slot_count[DEVPERINT];
+// Bitmap degli slot occupati di ciascun flash device
+HIDDEN unsigned int slot_used[DEVPERINT][SWAPSLOTWORDS];
+// Swap slot assegnati, in una tabella hash indicizzata per (asid, pagina)
+HIDDEN swap_slot_t slot_table[SLOTRECORDS];
+HIDDEN struct list_head slot_hash[SLOTBUCKETS];
+HIDDEN LIST_HEAD(slot_free_h);
+
+// Mutex sul disco usato come memoria secondaria
+HIDDEN int disk_sem;
+// Geometria del disco: settori per traccia, testine e cilindri
+HIDDEN int disk_sects, disk_heads, disk_cyls;
+// Cilindro su cui si trova la testina, -1 se non noto
+HIDDEN int disk_cylinder;
+// Numero di cluster del disco e bitmap dei cluster occupati
+HIDDEN int cluster_count;
+HIDDEN unsigned int cluster_used[DISKCLUSTERWORDS];
+
+// Bucket della tabella hash che contiene lo slot della pagina
+#define SLOTHASH(asid, page) (((page) * 7 + (asid)) % SLOTBUCKETS)
+
+// Ritorna lo slot assegnato alla pagina, NULL se assente
+HIDDEN swap_slot_t *find_slot(int asid, int page){
+	swap_slot_t *iter;
+	list_for_each_entry(iter, &slot_hash[SLOTHASH(asid, page)], sl_list)
+		if (iter->asid == asid && iter->page == page)
+			return iter;
+	return NULL;
+}
+
+// Associa alla pagina lo slot (dev, block), ritorna NULL se non ci sono record liberi
+HIDDEN swap_slot_t *new_slot(int asid, int page, int dev, int block){
+	if (list_empty(&slot_free_h))
+		return NULL;
+	swap_slot_t *slot = container_of(slot_free_h.next, swap_slot_t, sl_list);
+	list_del(&(slot->sl_list));
+	slot->asid = asid;
+	slot->page = page;
+	slot->dev = dev;
+	slot->block = block;
+	slot->written = FALSE;
+	list_add(&(slot->sl_list), &slot_hash[SLOTHASH(asid, page)]);
+	return slot;
+}
+
+/*
+	Ricava dall'header aout nel blocco 0 del device il numero di blocchi occupati dall'immagine: 0 se il device
+	non contiene un'immagine, tutti i blocchi se il device non e' leggibile o l'header non e' coerente.
+*/
+HIDDEN int read_image_area(int dev, int blocks){
+	// Il primo frame della swap pool non e' ancora in uso e fa da buffer
+	int status = (dev == MMAPDISK) ? disk_transfer(0, DISKREAD, 0) : flash_transfer(0, FLASHREAD, dev, 0);
+	if (status != READY)
+		return blocks;
+	int pages = aout_file_pages(FRAMEADDR(0));
+	if (pages == -1)
+		return 0;
+	return MIN(pages, blocks);
+}
+
+void initSwapSpace(){
+	for (int dev = 0; dev < DEVPERINT; dev++){
+		devreg_t *dev_reg = (devreg_t *) (DEVREGSTRT_ADDR + ((FLASHINT - 3) * 0x80) + (dev * 0x10));
+		image_area[dev] = 0;
+		slot_count[dev] = 0;
+		if (dev_reg->dtp.status != UNINSTALLED){
+			// Gli slot occupano gli ultimi blocchi del device, dopo la fine dell'immagine effettivamente presente
+			image_area[dev] = read_image_area(dev, flash_blocks(dev));
+			slot_count[dev] = MIN(SWAPSLOTS, flash_blocks(dev) - image_area[dev]);
+		}
+		for (int i = 0; i < SWAPSLOTWORDS; i++)
+			slot_used[dev][i] = 0;
+	}
+	INIT_LIST_HEAD(&slot_free_h);
+	for (int i = 0; i < SLOTBUCKETS; i++)
+		INIT_LIST_HEAD(&slot_hash[i]);
+	for (int i = 0; i < SLOTRECORDS; i++){
+		slot_table[i].page = -1;
+		list_add_tail(&(slot_table[i].sl_list), &slot_free_h);
+	}
+
+	disk_sem = 1;
+	disk_cylinder = -1;
+	cluster_count = 0;
+	for (int i = 0; i < DISKCLUSTERWORDS; i++)
+		cluster_used[i] = 0;
+	disk_cyls = disk_heads = disk_sects = 0;
+	image_area[MMAPDISK] = 0;
+	// La geometria serve anche per le regioni del disco mappate dagli U-proc, non solo per lo swap
+	devreg_t *disk_reg = (devreg_t *) (DEVREGSTRT_ADDR + ((DISKINT - 3) * 0x80) + (VMDISK * 0x10));
+	if (disk_reg->dtp.status != UNINSTALLED){
+		disk_cyls = DISKMAXCYL(disk_reg->dtp.data1);
+		disk_heads = DISKMAXHEAD(disk_reg->dtp.data1);
+		disk_sects = DISKMAXSECT(disk_reg->dtp.data1);
+#if BACKINGSTORE == FLASHBACK
+		// Il disco puo' contenere l'immagine di un U-proc lanciato con SPAWN
+		image_area[MMAPDISK] = read_image_area(MMAPDISK, disk_blocks());
+#endif
+#if BACKINGSTORE == DISKBACK
+		// Un cluster non e' mai diviso tra due cilindri, cosi' la sua lettura/scrittura non richiede seek
+		cluster_count = MIN(DISKCLUSTERS, disk_cyls * ((disk_heads * disk_sects) / SWAPCLUSTER));
+#endif
+	}
+}
+
+int image_area_blocks(int dev){
+	return image_area[dev];
+}
+
+int swap_area_start(int dev){
+	if (dev == MMAPDISK)
+		return (BACKINGSTORE == DISKBACK) ? 0 : disk_blocks();
+	return flash_blocks(dev) - slot_count[dev];
+}
+
+int swap_slot(int asid, int page, int *dev){
+	swap_slot_t *slot = find_slot(asid, page);
+	if (slot == NULL || !slot->written)
+		return -1;
+	*dev = slot->dev;
+	return slot->block;
+}
+
+// Assegna alle pagine del cluster di page un cluster libero del disco, ritorna FALSE se il disco e' pieno
+HIDDEN int alloc_disk_cluster(int asid, int page){
+	int first = page - (page % SWAPCLUSTER);
+	int per_cyl = (disk_heads * disk_sects) / SWAPCLUSTER;
+	// I cluster di indice basso sono piu' vicini al cilindro 0: allocandoli per primi si riducono i seek
+	for (int c = 0; c < cluster_count; c++)
+		if (!(cluster_used[c / 32] & (1 << (c % 32)))){
+			cluster_used[c / 32] |= 1 << (c % 32);
+			int base = (c / per_cyl) * disk_heads * disk_sects + (c % per_cyl) * SWAPCLUSTER;
+			// I record necessari sono garantiti: ogni cluster ne consuma al piu' SWAPCLUSTER
+			for (int i = 0; i < SWAPCLUSTER && first + i < KUSEGPAGES; i++)
+				if (find_slot(asid, first + i) == NULL)
+					new_slot(asid, first + i, SWAPDISK, base + i);
+			return TRUE;
+		}
+	return FALSE;
+}
+
+int alloc_swap_slot(int asid, int page, int *dev){
+	// Device da cui parte la ricerca del prossimo slot
+	static int next_dev = 0;
+	swap_slot_t *slot = find_slot(asid, page);
+
+	// Sul disco le pagine vicine finiscono in settori consecutivi: tutto il cluster riceve lo slot insieme
+	if (slot == NULL && BACKINGSTORE == DISKBACK && alloc_disk_cluster(asid, page))
+		slot = find_slot(asid, page);
+
+	// Le pagine salvate una dopo l'altra finiscono su device diversi, per distribuire occupazione e usura dei blocchi
+	for (int i = 0; i < DEVPERINT && slot == NULL; i++){
+		int d = (next_dev + i) % DEVPERINT;
+		for (int s = 0; s < slot_count[d]; s++)
+			if (!(slot_used[d][s / 32] & (1 << (s % 32)))){
+				slot_used[d][s / 32] |= 1 << (s % 32);
+				slot = new_slot(asid, page, d, flash_blocks(d) - 1 - s);
+				next_dev = (d + 1) % DEVPERINT;
+				break;
+			}
+	}
+	if (slot == NULL)
+		return -1;
+	*dev = slot->dev;
+	return slot->block;
+}
+
+void swap_write(int frame, support_t *curr_support, int asid, int page){
+	int dev, block = alloc_swap_slot(asid, page, &dev);
+	// La memoria secondaria e' esaurita
+	if (block == -1)
+		terminate(curr_support->sup_asid - 1);
+	/*
+		Lo slot e' valido gia' durante la scrittura, che puo' avvenire fuori dalla mutua esclusione sulla swap pool:
+		chi ha bisogno della pagina ne attende la fine con wait_page_io prima di leggerla.
+	*/
+	find_slot(asid, page)->written = TRUE;
+	pager_io(curr_support, frame, TRUE, dev, block, asid, page);
+}
+
+int swap_read(int frame, support_t *curr_support, int asid, int page){
+	int dev, block = swap_slot(asid, page, &dev);
+	if (block == -1)
+		return FALSE;
+	pager_io(curr_support, frame, FALSE, dev, block, asid, page);
+	return TRUE;
+}
+
+void free_swap_slots(int asid){
+	int per_cyl = (disk_heads * disk_sects) / SWAPCLUSTER;
+	for (int i = 0; i < SLOTRECORDS; i++){
+		swap_slot_t *slot = &slot_table[i];
+		// I record liberi hanno page == -1
+		if (slot->asid != asid || slot->page == -1)
+			continue;
+		if (slot->dev == SWAPDISK){
+			// Tutte le pagine del cluster liberano lo stesso bit
+			int cyl = slot->block / (disk_heads * disk_sects);
+			int c = cyl * per_cyl + (slot->block % (disk_heads * disk_sects)) / SWAPCLUSTER;
+			cluster_used[c / 32] &= ~(1 << (c % 32));
+		} else {
+			int s = flash_blocks(slot->dev) - 1 - slot->block;
+			slot_used[slot->dev][s / 32] &= ~(1 << (s % 32));
+		}
+		slot->page = -1;
+		list_del(&(slot->sl_list));
+		list_add(&(slot->sl_list), &slot_free_h);
+	}
+}
+
+int disk_blocks(){
+	return disk_cyls * disk_heads * disk_sects;
+}
+
+int disk_transfer(int frame, int operation, int block){
+	devreg_t *dev_reg = (devreg_t *) (DEVREGSTRT_ADDR + ((DISKINT - 3) * 0x80) + (VMDISK * 0x10));
+	// Conversione del settore lineare in (cilindro, testina, settore): settori consecutivi stanno sulla stessa traccia
+	int cyl = block / (disk_heads * disk_sects);
+	int head = (block / disk_sects) % disk_heads;
+	int sect = block % disk_sects;
+	int disk_status = READY;
+
+	SYSCALL(PASSEREN, (memaddr) &disk_sem, 0, 0);
+	// Il seek e' necessario solo se la testina non e' gia' sul cilindro, come accade nelle sequenze dello stesso cluster
+	if (cyl != disk_cylinder){
+		disk_status = SYSCALL(DOIO, (memaddr) &(dev_reg->dtp.command), (cyl << 8) | SEEKTOCYL, 0);
+		disk_cylinder = (disk_status == READY) ? cyl : -1;
+	}
+	if (disk_status == READY){
+		dev_reg->dtp.data0 = (memaddr) FRAMEADDR(frame);
+		disk_status = SYSCALL(DOIO, (memaddr) &(dev_reg->dtp.command), (head << 16) | (sect << 8) | operation, 0);
+	}
+	SYSCALL(VERHOGEN, (memaddr) &disk_sem, 0, 0);
+	if (operation == DISKWRITE)
+		image_written(MMAPDISK, block);
+	return disk_status;
+}
@@ -1,4 +1,6 @@
 #include "../h/sysSupport.h"
+#include "../h/vmSupport.h"
+#include "../h/initProc.h"
 
 extern int swap_pool_holding[UPROCMAX],
             swap_pool_semaphore,
@@ -6,8 +8,8 @@ extern int swap_pool_holding[UPROCMAX],
             tread_sem[UPROCMAX],
             twrite_sem[UPROCMAX]; 
 
-extern int master_semaphore; 
-extern swap_t swap_pool[POOLSIZE]; 
+extern int uproc_parent[UPROCMAX],
+            uproc_pid[UPROCMAX]; 
 
 void general_exception_handler() {
     // Ottengo la struttura di supporto del processo corrente
@@ -27,7 +29,8 @@ void general_exception_handler() {
             get_tod(exception_state);
             break;
         case TERMINATE: 
-            terminate(curr_support->sup_asid - 1);
+            // Lo stato di uscita (a1) viene consegnato al padre del nucleo tramite WAITCHILD
+            exit_uproc(curr_support->sup_asid - 1, exception_state->reg_a1);
             break;
         case WRITEPRINTER: 
             write_to_printer(exception_state, curr_support->sup_asid - 1);
@@ -38,6 +41,24 @@ void general_exception_handler() {
         case READTERMINAL: 
             read_from_terminal(exception_state, curr_support->sup_asid - 1);
             break;
+        case FORK: 
+            fork_uproc(exception_state, curr_support);
+            break;
+        case PINPAGES: 
+            pin_uproc_pages(exception_state, curr_support);
+            break;
+        case UNPINPAGES: 
+            unpin_uproc_pages(exception_state, curr_support);
+            break;
+        case SBRK: 
+            sbrk_uproc(exception_state, curr_support);
+            break;
+        case MMAP: 
+            mmap_uproc(exception_state, curr_support);
+            break;
+        case SPAWN: 
+            spawn_uproc(exception_state, curr_support);
+            break;
         default: 
             terminate(curr_support->sup_asid - 1);
             break;
@@ -56,21 +77,194 @@ void get_tod (state_t *exception_state) {
 
 // SYS2
 void terminate (int asid) {
-    // I frame occupati dal processo che deve essere terminato, devono essere marcati liberi
-    for (int i = 0; i < POOLSIZE; i++){
-        if (swap_pool[i].sw_asid == asid + 1){
-            swap_pool[i].sw_asid = NOPROC; 
-        }
+    exit_uproc(asid, KILLEDSTATUS);
+}
+
+void exit_uproc (int asid, int status) {
+    // Le liste dei frame liberi/occupati vanno modificate in mutua esclusione
+    if (!swap_pool_holding[asid]){
+        SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+        swap_pool_holding[asid] = 1; 
     }
+    // Vanno rilasciate anche le risorse dei figli creati con FORK, che release_uproc elimina prima dal nucleo
+    release_uproc(asid);
     // La mutua esclusione sulla swap pool table deve essere rilasciata prima di terminare
-    if (swap_pool_holding[asid]){
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    // Termina l'esecuzione del processo corrente
+    SYSCALL(TERMPROCESS, 0, status, 0); 
+}
+
+// Ritorna un U-proc della discendenza di asid (asid compreso) nel pager o con una pagina in trasferimento, -1 se nessuno
+HIDDEN int busy_descendant(int asid) {
+    if (pager_busy(asid) || page_io_doer(asid, -1) != -1)
+        return asid;
+    for (int i = 0; i < UPROCMAX; i++)
+        if (uproc_parent[i] == asid){
+            int busy = busy_descendant(i);
+            if (busy != -1)
+                return busy;
+        }
+    return -1;
+}
+
+void release_uproc(int asid) {
+    // Il processo non ha piu' trasferimenti in corso: chi lo attendeva viene svegliato
+    reset_io_state(asid);
+    // I figli vengono rilasciati prima del padre
+    for (int i = 0; i < UPROCMAX; i++){
+        /*
+            Un processo eliminato dal nucleo non deve detenere semafori condivisi. I semafori del terminale e della
+            stampante sono dello slot, e alloc_uproc_slot li reimposta quando lo slot viene riusato; quelli dei flash
+            device e del disco sono invece condivisi, e vengono acquisiti dal pager fuori dalla mutua esclusione sulla
+            swap pool. Per questo si attende (rilasciando il mutex) che nessun processo della discendenza sia nel pager,
+            e che nessuno stia salvando una sua pagina in uno slot che sta per essere liberato. Durante l'attesa il
+            figlio potrebbe terminare da solo e liberare lo slot.
+        */
+        int busy;
+        while (uproc_parent[i] == asid && (busy = busy_descendant(i)) != -1){
+            int doer = pager_busy(busy) ? busy : page_io_doer(busy, -1);
+            wait_io(doer, doer == busy);
+        }
+        if (uproc_parent[i] != asid)
+            continue;
+        /*
+            Il figlio (con la sua discendenza) viene eliminato dal nucleo prima di liberarne frame e ASID:
+            non deve piu' essere eseguito sui frame rilasciati, ne' ricevere il mutex sulla swap pool
+            (detenuto dal chiamante) se era bloccato in attesa. Un PID non piu' valido viene ignorato.
+        */
+        SYSCALL(TERMPROCESS, uproc_pid[i], KILLEDSTATUS, 0);
+        release_uproc(i);
+    }
+    // Le pagine del processo che un altro processo sta salvando vengono liberate a scrittura completata
+    wait_page_io(asid, -1);
+    // I frame occupati dal processo che deve essere terminato, devono essere marcati liberi
+    free_asid_frames(asid);
+    release_asid(asid);
+    uproc_parent[asid] = SLOTFREE;
+    uproc_pid[asid] = NOPROC;
+}
+
+// SYS6
+void fork_uproc (state_t *exception_state, support_t *curr_support) {
+    int asid = curr_support->sup_asid - 1;
+    state_t child_state;
+
+    // La page table del padre non deve cambiare durante la copia
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    swap_pool_holding[asid] = 1; 
+    // Le pagine del padre che un altro processo sta salvando vengono copiate solo a scrittura completata
+    wait_page_io(asid, -1);
+
+    int child = alloc_uproc_slot(asid);
+    if (child == -1){
+        // Non ci sono slot liberi per un nuovo U-proc
         swap_pool_holding[asid] = 0; 
         SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+        exception_state->reg_v0 = -1;
+        return;
     }
-    // Sblocca test
-    SYSCALL(VERHOGEN, (memaddr) &master_semaphore, 0, 0);
-    // Termina l'esecuzione del processo corrente
-    SYSCALL(TERMPROCESS, 0, 0, 0); 
+    support_t *child_support = init_uproc_support(child);
+    // Le pagine residenti del padre vengono condivise in sola lettura e copiate alla prima scrittura
+    vm_fork(curr_support, child_support);
+
+    // Il figlio riprende dall'istruzione successiva alla SYSCALL, con valore di ritorno 0 e il proprio ASID
+    copy_state(&child_state, exception_state);
+    child_state.pc_epc += WORDLEN;
+    child_state.reg_t9 += WORDLEN;
+    child_state.reg_v0 = 0;
+    child_state.entry_hi = (child_state.entry_hi & ~ENTRYHI_ASID_MASK) | (child_support->sup_tlbAsid << ASIDSHIFT);
+
+    // NSYS1, ancora in mutua esclusione: il PID va registrato prima che il figlio possa terminare e liberare lo slot
+    int pid = SYSCALL(CREATEPROCESS, (memaddr) &child_state, PROCESS_PRIO_LOW, (memaddr) child_support);
+    if (pid < 0)
+        release_uproc(child);
+    else
+        uproc_pid[child] = pid;
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    if (pid < 0){
+        exception_state->reg_v0 = -1;
+        return;
+    }
+    // Al padre viene restituito l'ASID del figlio
+    exception_state->reg_v0 = child + 1;
+}
+
+// SYS7
+void pin_uproc_pages (state_t *exception_state, support_t *curr_support) {
+    int asid = curr_support->sup_asid - 1;
+
+    // Il caricamento delle pagine e la marcatura dei frame avvengono in mutua esclusione sulla swap pool
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    swap_pool_holding[asid] = 1; 
+    int pinned = pin_pages(curr_support, exception_state->reg_a1, exception_state->reg_a2);
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+
+    exception_state->reg_v0 = pinned ? 0 : -1;
+}
+
+// SYS8
+void unpin_uproc_pages (state_t *exception_state, support_t *curr_support) {
+    int asid = curr_support->sup_asid - 1;
+
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    swap_pool_holding[asid] = 1; 
+    unpin_pages(curr_support, exception_state->reg_a1, exception_state->reg_a2);
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+
+    exception_state->reg_v0 = 0;
+}
+
+// SYS9
+void sbrk_uproc (state_t *exception_state, support_t *curr_support) {
+    int asid = curr_support->sup_asid - 1;
+
+    // Le pagine dell'heap vengono allocate dal pager al primo accesso, qui si sposta solo il limite
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    swap_pool_holding[asid] = 1; 
+    exception_state->reg_v0 = heap_grow(curr_support, exception_state->reg_a1);
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+}
+
+// SYS10
+void mmap_uproc (state_t *exception_state, support_t *curr_support) {
+    int asid = curr_support->sup_asid - 1;
+
+    // Le pagine della regione vengono lette dal device dal pager al primo accesso
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    swap_pool_holding[asid] = 1; 
+    exception_state->reg_v0 = mmap_region(curr_support, exception_state->reg_a1, exception_state->reg_a2, exception_state->reg_a3);
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+}
+
+// SYS11
+void spawn_uproc (state_t *exception_state, support_t *curr_support) {
+    int asid = curr_support->sup_asid - 1;
+    int dev = exception_state->reg_a1;
+    exception_state->reg_v0 = -1;
+
+    // L'immagine puo' trovarsi su un flash device installato o sul disco, se questo non ospita lo swap
+    if (dev == MMAPDISK ? (BACKINGSTORE == DISKBACK || disk_blocks() == 0) : (dev < 0 || dev >= DEVPERINT || flash_blocks(dev) == 0))
+        return;
+
+    SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    swap_pool_holding[asid] = 1; 
+    int child = load_uproc(dev, asid);
+    // NSYS1, in mutua esclusione come per FORK: il PID va registrato prima che il figlio possa terminare
+    int pid = (child == -1) ? -1 : start_uproc(child);
+    if (child != -1 && pid < 0)
+        release_uproc(child);
+    swap_pool_holding[asid] = 0; 
+    SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+    if (pid < 0)
+        return;
+    // Al padre viene restituito l'identificativo del figlio, come per FORK
+    exception_state->reg_v0 = child + 1;
 }
 
 // SYS3
@@ -0,0 +1,258 @@
+#include "../h/tlb.h"
+
+extern pteEntry_t *get_pte(support_t *curr_support, unsigned int entry_hi);
+
+// Cache software delle traduzioni usate di recente
+HIDDEN stlb_entry_t stlb[STLBSIZE];
+// Entry della cache software caricata in ciascuna entry del TLB, -1 se la entry del TLB e' libera
+HIDDEN int tlb_shadow[TLBSIZE];
+// Pagine piu' usate di ciascun ASID (indici della cache software, -1 se liberi), indicizzate per ASID
+HIDDEN int hot_pages[ASIDMAX + 1][TLBPRELOAD];
+// ASID (e relativa generazione) dell'ultimo processo per cui e' stato fatto il preload
+HIDDEN int preload_asid;
+HIDDEN unsigned int preload_gen;
+// Contatori dei refill, consultabili dal debugger di uMPS3
+tlb_stats_t tlb_stats;
+
+void initTLB(){
+	for (int e = 0; e < STLBSIZE; e++){
+		stlb[e].key = 0;
+		stlb[e].reuse = STLBGAPMAX;
+		stlb[e].evicted = 0;
+		stlb[e].tlb_index = -1;
+	}
+	for (int i = 0; i < TLBSIZE; i++)
+		tlb_shadow[i] = -1;
+	for (int asid = 0; asid <= ASIDMAX; asid++)
+		for (int i = 0; i < TLBPRELOAD; i++)
+			hot_pages[asid][i] = -1;
+	preload_asid = -1;
+	preload_gen = 0;
+	tlb_stats.refills = 0;
+	tlb_stats.stlb_hits = 0;
+	tlb_stats.stlb_misses = 0;
+	tlb_stats.evictions = 0;
+	tlb_stats.preloads = 0;
+}
+
+void tlb_refill(support_t *curr_support, unsigned int entry_hi){
+	tlb_stats.refills++;
+	/*
+		Le pagine rimaste nel TLB non generano refill e la loro distanza di riuso non viene piu' misurata:
+		raddoppiandola, una pagina che non serve piu' diventa prima o poi la vittima, mentre una ancora usata
+		rientra subito con una nuova misura bassa.
+	*/
+	if (tlb_stats.refills % STLBAGING == 0)
+		for (int i = 0; i < STLBSIZE; i++)
+			if (stlb[i].tlb_index != -1)
+				stlb[i].reuse = MIN(stlb[i].reuse * 2 + 1, STLBGAPMAX);
+
+	int e = stlb_lookup(entry_hi);
+	pteEntry_t *pte;
+	if (e != -1){
+		tlb_stats.stlb_hits++;
+		pte = stlb[e].pte;
+	} else {
+		tlb_stats.stlb_misses++;
+		// Recupero della page table entry (privata o del segmento condiviso) della pagina che non si trova nel TLB
+		pte = get_pte(curr_support, entry_hi);
+		if (pte == NULL){
+			// Indirizzo fuori dall'address space o tabella di secondo livello non ancora allocata: una entry non valida fa intervenire il pager
+			tlb_place(-1, entry_hi, 0, tlb_victim());
+			return;
+		}
+		e = stlb_insert(entry_hi, pte);
+	}
+	// La pagina era gia' nella cache software: il tempo trascorso fuori dal TLB misura quanto e' usata
+	if (stlb[e].evicted != 0 && stlb[e].tlb_index == -1){
+		unsigned int gap = tlb_stats.refills - stlb[e].evicted;
+		stlb[e].reuse = (stlb[e].reuse == STLBGAPMAX) ? gap : (stlb[e].reuse + gap) / 2;
+	}
+	// Le pagine del segmento condiviso sono globali e non vengono associate ad un ASID
+	if ((entry_hi >> SHAREDSEGFLAG) != SHARED)
+		hot_update(ENTRYHI_GET_ASID(entry_hi), e);
+
+	// La pagina viene caricata al posto di quella con la distanza di riuso maggiore, non in una entry casuale
+	tlb_write(e, tlb_victim());
+}
+
+void tlb_write(int e, int index){
+	tlb_place(e, stlb[e].pte->pte_entryHI, stlb[e].pte->pte_entryLO, index);
+}
+
+void tlb_place(int e, unsigned int entry_hi, unsigned int entry_lo, int index){
+	if (tlb_shadow[index] != -1){
+		stlb[tlb_shadow[index]].tlb_index = -1;
+		stlb[tlb_shadow[index]].evicted = tlb_stats.refills;
+		tlb_stats.evictions++;
+	}
+	// Una pagina refillata mentre e' ancora nel TLB (ad esempio dopo un TLBP fallito) non deve occupare due entry
+	if (e != -1 && stlb[e].tlb_index != -1)
+		tlb_shadow[stlb[e].tlb_index] = -1;
+	// Una entry senza pagina della cache software (e == -1) resta libera per tlb_victim
+	tlb_shadow[index] = e;
+	if (e != -1)
+		stlb[e].tlb_index = index;
+
+	setENTRYHI(entry_hi);
+	setENTRYLO(entry_lo);
+	setINDEX(index << TLBINDEXSHIFT);
+	TLBWI();
+}
+
+unsigned int stlb_key(unsigned int entry_hi){
+	// Le pagine del segmento condiviso sono globali, quindi l'ASID non fa parte della chiave
+	if ((entry_hi >> SHAREDSEGFLAG) == SHARED)
+		return entry_hi & ~(PAGESIZE - 1);
+	return entry_hi & (~(PAGESIZE - 1) | ENTRYHI_ASID_MASK);
+}
+
+// Funzione hash della cache software, che mescola VPN e ASID
+#define STLBHASH(key) ((((key) >> VPNSHIFT) ^ ((key) >> ASIDSHIFT) * 7) & (STLBSIZE - 1))
+
+int stlb_lookup(unsigned int entry_hi){
+	unsigned int key = stlb_key(entry_hi);
+	for (int i = 0; i < STLBPROBE; i++){
+		int e = (STLBHASH(key) + i) & (STLBSIZE - 1);
+		if (stlb[e].key == key)
+			return e;
+	}
+	return -1;
+}
+
+int stlb_insert(unsigned int entry_hi, pteEntry_t *pte){
+	unsigned int key = stlb_key(entry_hi);
+	int victim = STLBHASH(key);
+	for (int i = 0; i < STLBPROBE; i++){
+		int e = (STLBHASH(key) + i) & (STLBSIZE - 1);
+		if (stlb[e].key == 0){
+			victim = e;
+			break;
+		}
+		if (stlb[e].reuse > stlb[victim].reuse)
+			victim = e;
+	}
+	// La entry rimpiazzata non e' piu' associata alla sua posizione nel TLB
+	if (stlb[victim].key != 0 && stlb[victim].tlb_index != -1)
+		tlb_shadow[stlb[victim].tlb_index] = -1;
+	stlb[victim].key = key;
+	stlb[victim].pte = pte;
+	// Una pagina appena inserita non ha ancora una misura ed e' la prima candidata a lasciare il TLB
+	stlb[victim].reuse = STLBGAPMAX;
+	stlb[victim].evicted = 0;
+	stlb[victim].tlb_index = -1;
+	return victim;
+}
+
+void hot_update(int asid, int e){
+	if (asid < 1 || asid > ASIDMAX)
+		return;
+	int *hot = hot_pages[asid];
+	int victim = 0;
+	for (int i = 0; i < TLBPRELOAD; i++){
+		if (hot[i] == e)
+			return;
+		// Un indice libero, o riusato dalla cache software per un altro ASID, va sostituito per primo
+		if (hot[i] == -1 || stlb[hot[i]].key == 0 || ENTRYHI_GET_ASID(stlb[hot[i]].key) != asid){
+			hot[i] = e;
+			return;
+		}
+		if (stlb[hot[i]].reuse > stlb[hot[victim]].reuse)
+			victim = i;
+	}
+	if (stlb[hot[victim]].reuse > stlb[e].reuse)
+		hot[victim] = e;
+}
+
+void tlb_preload(unsigned int entry_hi){
+	int asid = ENTRYHI_GET_ASID(entry_hi);
+	if (asid < 1 || asid > ASIDMAX)
+		return;
+	// Se l'ultimo processo per cui e' stato fatto il preload torna subito in esecuzione, il TLB e' gia' pronto
+	if (asid == preload_asid && asid_generation(asid) == preload_gen)
+		return;
+	preload_asid = asid;
+	preload_gen = asid_generation(asid);
+
+	for (int i = 0; i < TLBPRELOAD; i++){
+		int e = hot_pages[asid][i];
+		if (e == -1 || stlb[e].key == 0 || ENTRYHI_GET_ASID(stlb[e].key) != asid)
+			continue;
+		// Pagine gia' nel TLB o non valide (il refill farebbe comunque intervenire il pager) vengono saltate
+		if (stlb[e].tlb_index != -1 || !(stlb[e].pte->pte_entryLO & VALIDON))
+			continue;
+		// Due entry del TLB con la stessa pagina non sono ammesse: si verifica che non sia rimasta una copia non tracciata
+		setENTRYHI(stlb[e].pte->pte_entryHI);
+		TLBP();
+		if ((getINDEX() & PRESENTFLAG) == 0)
+			continue;
+		tlb_write(e, tlb_victim());
+		tlb_stats.preloads++;
+	}
+}
+
+int tlb_victim(){
+	// Posizione da cui parte la ricerca, a rotazione per distribuire le sovrascritture a parita' di distanza di riuso
+	static int next_index = 0;
+	int victim = next_index;
+	for (int i = 0; i < TLBSIZE; i++){
+		int index = (next_index + i) % TLBSIZE;
+		if (tlb_shadow[index] == -1){
+			victim = index;
+			break;
+		}
+		if (stlb[tlb_shadow[index]].reuse > stlb[tlb_shadow[victim]].reuse)
+			victim = index;
+	}
+	next_index = (victim + 1) % TLBSIZE;
+	return victim;
+}
+
+void stlb_flush_asid(int asid){
+	for (int e = 0; e < STLBSIZE; e++)
+		if (stlb[e].key != 0 && (stlb[e].key >> SHAREDSEGFLAG) != SHARED && ENTRYHI_GET_ASID(stlb[e].key) == asid){
+			// La entry del TLB resta valida per l'hardware, ma non e' piu' riconducibile alla cache software
+			if (stlb[e].tlb_index != -1)
+				tlb_shadow[stlb[e].tlb_index] = -1;
+			stlb[e].key = 0;
+			stlb[e].tlb_index = -1;
+		}
+	// Le pagine piu' usate indicano entry della cache software appena rimosse
+	for (int i = 0; i < TLBPRELOAD; i++)
+		hot_pages[asid][i] = -1;
+}
+
+void stlb_remove(unsigned int entry_hi){
+	int e = stlb_lookup(entry_hi);
+	if (e == -1)
+		return;
+	if (stlb[e].tlb_index != -1)
+		tlb_shadow[stlb[e].tlb_index] = -1;
+	stlb[e].key = 0;
+	stlb[e].tlb_index = -1;
+}
+
+void tlb_flush_asid(int asid){
+	// TLBR sovrascrive EntryHi, il cui campo ASID e' quello del processo corrente: va ripristinato alla fine
+	unsigned int entry_hi = getENTRYHI();
+	// Le entry del TLB con l'ASID vengono sostituite da entry non valide per indirizzi del kernel, che non passano dal TLB
+	for (int index = 0; index < TLBSIZE; index++){
+		setINDEX(index << TLBINDEXSHIFT);
+		TLBR();
+		if (ENTRYHI_GET_ASID(getENTRYHI()) != asid || (getENTRYLO() & GLOBALON))
+			continue;
+		setENTRYHI(index << VPNSHIFT);
+		setENTRYLO(0);
+		TLBWI();
+		tlb_shadow[index] = -1;
+	}
+	setENTRYHI(entry_hi);
+	stlb_flush_asid(asid);
+}
+
+void tlb_shadow_clear(){
+	for (int i = 0; i < TLBSIZE; i++)
+		tlb_shadow[i] = -1;
+	for (int e = 0; e < STLBSIZE; e++)
+		stlb[e].tlb_index = -1;
+}
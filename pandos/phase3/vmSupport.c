@@ -5,134 +5,1483 @@ int swap_pool_semaphore;
 // Vettore di interi usato per tenere traccia di quale processo possiede il mutex sulla swap pool
 int swap_pool_holding[UPROCMAX]; 
 // Swap pool: struttura dati per supportare la memoria virtuale con informazioni riguardo i frame nella RAM (occupati/liberi, etc...).
-swap_t swap_pool[POOLSIZE]; 
+swap_t *swap_pool; 
+// Numero di frame della swap pool, calcolato all'avvio in base alla RAM installata
+int swap_pool_size;
+// Indirizzo fisico del primo frame della swap pool
+memaddr swap_pool_start;
+// Lista dei frame liberi della swap pool, e loro numero
+HIDDEN LIST_HEAD(swap_free_h);
+HIDDEN int free_count;
+// Liste dei frame occupati da ciascun U-proc, indicizzate per asid - 1
+HIDDEN struct list_head swap_asid_h[UPROCMAX];
+/*
+	Nodi delle mappature dei frame condivisi (page cache e copy-on-write), uno per ogni coppia (U-proc, frame):
+	il nodo e' nella lista swap_shared_h dell'U-proc finche' questo mappa il frame.
+*/
+HIDDEN struct list_head *shared_node;
+HIDDEN struct list_head swap_shared_h[UPROCMAX];
+
+// Page table del segmento condiviso KUSEG3, comune a tutti gli U-proc
+pteEntry_t shared_pgTbl[SHAREDPAGES];
+// Page cache delle pagine di .text condivise, tabella hash indicizzata per (immagine, pagina)
+HIDDEN struct list_head page_cache_h[PAGECACHESIZE];
+// Generazione del contenuto di ciascun device (indice MMAPDISK per il disco), parte dell'identita' delle immagini
+HIDDEN unsigned int image_gen[DEVPERINT + 1];
+/*
+	Identita' del contenuto dell'immagine di ciascun device: hash dei blocchi dell'immagine e IMAGEID usato dalla page cache,
+	condiviso dai device con lo stesso contenuto. ident_gen vale la generazione a cui si riferiscono piu' uno, 0 se da calcolare.
+*/
+HIDDEN unsigned int image_hash[DEVPERINT + 1];
+HIDDEN unsigned int image_ident[DEVPERINT + 1];
+HIDDEN unsigned int ident_gen[DEVPERINT + 1];
+
+// Stato della lettura anticipata di ciascun U-proc, indicizzato per asid - 1
+HIDDEN prefetch_t prefetch_state[UPROCMAX];
+// Informazioni sull'immagine aout di ciascun U-proc, indicizzate per asid - 1
+HIDDEN image_t image_info[UPROCMAX];
+// Resident set e working set di ciascun U-proc, indicizzati per asid - 1
+HIDDEN wset_t wset[UPROCMAX];
+// Semafori su cui il controllo di ammissione sospende gli U-proc, indicizzati per asid - 1
+HIDDEN int wset_sem[UPROCMAX];
+// Stato dell'I/O del pager di ciascun U-proc, indicizzato per asid - 1
+HIDDEN io_t io_state[UPROCMAX];
+// Semafori su cui si attende la fine dell'I/O di un altro U-proc, indicizzati per asid - 1 (UPROCMAX per test)
+HIDDEN int io_sem[UPROCMAX + 1];
+// Numero di pagine bloccate in memoria da ciascun U-proc, indicizzato per asid - 1
+HIDDEN int pinned_pages[UPROCMAX];
+// Numero di frame della swap pool bloccati in memoria, per qualsiasi motivo
+HIDDEN int pinned_count;
+// Primo dei due frame di appoggio, fuori dalla swap pool, in cui vm_load legge e confronta i blocchi delle immagini
+HIDDEN int scratch_frame;
+// Pagina piu' bassa dello stack di ciascun U-proc, indicizzata per asid - 1
+HIDDEN int stack_bottom[UPROCMAX];
+// Fine dell'heap di ciascun U-proc (primo indirizzo non allocato), indicizzata per asid - 1
+HIDDEN memaddr heap_end[UPROCMAX];
+// Regioni di device mappate da ciascun U-proc, indicizzate per asid - 1
+HIDDEN mmap_t mmap_table[UPROCMAX][MMAPMAX];
+// Contatori del pager, consultabili dal debugger di uMPS3
+pager_stats_t pager_stats;
 
 extern pcb_PTR current_p; 
 extern int flash_sem[UPROCMAX];
+extern zswap_stats_t zswap_stats;
 
 void initSwapStructs(){
 	swap_pool_semaphore = 1;
+	pinned_count = 0;
+	INIT_LIST_HEAD(&swap_free_h);
+	for (int i = 0; i < PAGECACHESIZE; i++)
+		INIT_LIST_HEAD(&page_cache_h[i]);
+	for (int i = 0; i <= DEVPERINT; i++)
+		image_gen[i] = ident_gen[i] = 0;
+	for (int i = 0; i < SHAREDPAGES; i++){
+		// Le entry del segmento condiviso hanno il bit G acceso: l'ASID non viene confrontato
+		shared_pgTbl[i].pte_entryHI = (SHARED << SHAREDSEGFLAG) | (i << VPNSHIFT);
+		shared_pgTbl[i].pte_entryLO = GLOBALON | DIRTYON;
+	}
+
+	// Ricavo del RAMTOP
+	memaddr ram_top; 
+	RAMTOP(ram_top);
+	/*
+		La fine dell'immagine del kernel (.data e .bss compresi) si ricava dall'header aout,
+		che viene caricato in memoria all'inizio della sezione .text del kernel.
+	*/
+	memaddr kernel_end = *((memaddr *) (KERNELSTACK + AOUT_DATAVADDR)) + *((memaddr *) (KERNELSTACK + AOUT_DATAMEMSZ));
+	// La swap pool occupa tutti i frame compresi tra la fine del kernel e gli stack del livello di supporto
+	memaddr area_start = (kernel_end + PAGESIZE - 1) & ~(PAGESIZE - 1);
+	memaddr area_end = ram_top - SUPSTACKFRAMES * PAGESIZE;
+	int area_frames = (area_end - area_start) / PAGESIZE;
+	// I primi frame dell'area ospitano la swap pool table stessa
+	int table_frames = (area_frames * sizeof(swap_t) + PAGESIZE - 1) / PAGESIZE;
+
+	swap_pool = (swap_t *) area_start;
+	swap_pool_size = area_frames - table_frames;
+	swap_pool_start = area_start + table_frames * PAGESIZE;
+
+	initSwapSpace();
+#if ZSWAPRATIO > 0
+	// Il tier compresso occupa gli ultimi frame dell'area, preceduti dalla tabella dei successori dei chunk
+	int zswap_frames = swap_pool_size / ZSWAPRATIO;
+	int zswap_table = (zswap_frames * ZCHUNKSPERFRAME * sizeof(int) + PAGESIZE - 1) / PAGESIZE;
+	swap_pool_size -= zswap_frames + zswap_table;
+	zswap_init(FRAMEADDR(swap_pool_size + zswap_table), zswap_frames, (int *) FRAMEADDR(swap_pool_size));
+#else
+	zswap_init(0, 0, NULL);
+#endif
+#if PGTABLEMODE == PGINVERTED
+	// La page table invertita occupa i frame che precedono il tier compresso, in proporzione alla swap pool
+	int ipt_entries = swap_pool_size * IPTFACTOR;
+	swap_pool_size -= (ipt_entries * sizeof(ipt_t) + PAGESIZE - 1) / PAGESIZE;
+	initPgTable((ipt_t *) FRAMEADDR(swap_pool_size), ipt_entries);
+#else
+	initPgTable(NULL, 0);
+#endif
+	// I nodi delle mappature condivise occupano i frame che precedono la page table invertita
+	int node_frames = (UPROCMAX * swap_pool_size * sizeof(struct list_head) + PAGESIZE - 1) / PAGESIZE;
+	swap_pool_size -= node_frames;
+	shared_node = (struct list_head *) FRAMEADDR(swap_pool_size);
+	for (int i = 0; i < UPROCMAX * swap_pool_size; i++)
+		INIT_LIST_HEAD(&shared_node[i]);
+	// Gli ultimi due frame rimasti fanno da buffer per le letture fatte in mutua esclusione sulla swap pool fuori dal pager
+	swap_pool_size -= 2;
+	scratch_frame = swap_pool_size;
+
 	// Poiche' solo gli ASID di valore positivo sono valori "legali", un frame non occupato e' segnato come frame occupato da un processo con ASID -1. 
-	for (int i = 0; i < POOLSIZE; i++)
+	for (int i = 0; i < swap_pool_size; i++){
 		swap_pool[i].sw_asid = NOPROC;
-	for (int i = 0; i < UPROCMAX; i++)
+		swap_pool[i].sw_flags = 0;
+		swap_pool[i].sw_refcnt = 0;
+		// Inizialmente tutti i frame sono liberi
+		list_add_tail(&(swap_pool[i].sw_list), &swap_free_h);
+	}
+	free_count = swap_pool_size;
+	io_sem[UPROCMAX] = 0;
+	for (int i = 0; i < UPROCMAX; i++){
 		swap_pool_holding[i] = 0;
+		reset_io_state(i);
+		INIT_LIST_HEAD(&swap_asid_h[i]);
+		INIT_LIST_HEAD(&swap_shared_h[i]);
+		prefetch_state[i].last_page = -1;
+		prefetch_state[i].stride = 0;
+		prefetch_state[i].window = 0;
+		image_info[i].parsed = 0;
+		image_info[i].image_dev = i;
+		image_info[i].support = NULL;
+		reset_working_set(i);
+		pinned_pages[i] = 0;
+		stack_bottom[i] = STACKTOPPAGE;
+		heap_end[i] = KUSEG;
+		for (int j = 0; j < MMAPMAX; j++)
+			mmap_table[i][j].pages = 0;
+	}
+	pager_stats.misses = 0;
+	pager_stats.zero_fills = 0;
+	pager_stats.cache_hits = 0;
+	pager_stats.cow_copies = 0;
+	pager_stats.prefetched = 0;
+	pager_stats.prefetch_hits = 0;
+	pager_stats.prefetch_wasted = 0;
+	pager_stats.ref_faults = 0;
+	pager_stats.local_evictions = 0;
+	pager_stats.suspensions = 0;
+	pager_stats.cluster_evictions = 0;
+	pager_stats.stack_growths = 0;
+}
+
+int alloc_frame(){
+	if (list_empty(&swap_free_h))
+		return -1;
+	// Si prende il primo frame libero (ovvero il successore della sentinella)
+	swap_t *free_entry = container_of(swap_free_h.next, swap_t, sw_list);
+	list_del(swap_free_h.next);
+	free_count--;
+	return free_entry - swap_pool;
+}
+
+int free_frames(){
+	return free_count;
+}
+
+int pinned_frames(){
+	return pinned_count;
+}
+
+void pin_frame(int frame){
+	if (!(swap_pool[frame].sw_flags & SW_PINNED)){
+		swap_pool[frame].sw_flags |= SW_PINNED;
+		pinned_count++;
+	}
+}
+
+void unpin_frame(int frame){
+	if (swap_pool[frame].sw_flags & SW_PINNED){
+		swap_pool[frame].sw_flags &= ~SW_PINNED;
+		pinned_count--;
+	}
+}
+
+void release_frame(int frame){
+	swap_pool[frame].sw_flags &= ~SW_BUSY;
+	list_add_tail(&(swap_pool[frame].sw_list), &swap_free_h);
+	free_count++;
+}
+
+// Nodo della mappatura del frame condiviso da parte dell'U-proc asid (asid - 1)
+#define SHAREDNODE(asid, frame) (&shared_node[(asid) * swap_pool_size + (frame)])
+
+void share_frame(int asid, int frame){
+	swap_pool[frame].sw_refcnt++;
+	list_add_tail(SHAREDNODE(asid, frame), &swap_shared_h[asid]);
+}
+
+void unshare_frame(int asid, int frame){
+	swap_pool[frame].sw_refcnt--;
+	list_del(SHAREDNODE(asid, frame));
+	INIT_LIST_HEAD(SHAREDNODE(asid, frame));
+}
+
+int maps_shared(int asid, int frame){
+	return !list_empty(SHAREDNODE(asid, frame));
+}
+
+void free_asid_frames(int asid){
+	support_t *support = image_info[asid].support;
+	// Rilascio dei riferimenti ai frame condivisi (.text e copy-on-write) mappati dal processo, senza scorrere la page table
+	while (!list_empty(&swap_shared_h[asid])){
+		int frame = (swap_shared_h[asid].next - shared_node) % swap_pool_size;
+		unshare_frame(asid, frame);
+		if (swap_pool[frame].sw_asid == COWFRAME && swap_pool[frame].sw_refcnt == 0){
+			swap_pool[frame].sw_asid = NOPROC;
+			release_frame(frame);
+		}
+	}
+	// Si scorrono solo i frame effettivamente occupati dal processo, non l'intera swap pool
+	while (!list_empty(&swap_asid_h[asid])){
+		swap_t *entry = container_of(swap_asid_h[asid].next, swap_t, sw_list);
+		list_del(&(entry->sw_list));
+		if (entry->sw_flags & SW_PREFETCHED)
+			pager_stats.prefetch_wasted++;
+		// Le pagine mappate modificate vengono riportate sul device prima che la regione sparisca
+		if ((entry->sw_flags & SW_DIRTY) && support != NULL)
+			mmap_operation(entry - swap_pool, TRUE, support, asid, entry->sw_pageNo);
+		// Le pagine bloccate con SYS7 e non sbloccate smettono di contare nel limite globale
+		unpin_frame(entry - swap_pool);
+		entry->sw_asid = NOPROC;
+		entry->sw_flags = 0;
+		release_frame(entry - swap_pool);
+	}
+	// Le entry della page table vengono liberate per ultime, dopo essere state consultate
+	if (support != NULL)
+		free_pgtable(support);
+	// Le informazioni sull'immagine non sono piu' valide
+	image_info[asid].parsed = 0;
+	image_info[asid].support = NULL;
+	pinned_pages[asid] = 0;
+	stack_bottom[asid] = STACKTOPPAGE;
+	heap_end[asid] = KUSEG;
+	for (int i = 0; i < MMAPMAX; i++)
+		mmap_table[asid][i].pages = 0;
+	zswap_drop_asid(asid);
+	free_swap_slots(asid);
+	// Il working set del processo terminato libera spazio per quelli sospesi
+	reset_working_set(asid);
+	admit_suspended();
+}
+
+// Ritorna l'indice del semaforo io_sem del processo corrente: asid - 1 per gli U-proc, UPROCMAX per test
+HIDDEN int io_self(){
+	support_t *curr_support = (support_t *) SYSCALL(GETSUPPORTPTR, 0, 0, 0);
+	return curr_support == NULL ? UPROCMAX : curr_support->sup_asid - 1;
+}
+
+// Sveglia i processi registrati sull'U-proc asid (asid - 1), uno per registrazione. Da chiamare in mutua esclusione
+HIDDEN void io_wake(int asid){
+	unsigned int waiters = io_state[asid].waiters;
+	io_state[asid].waiters = 0;
+	for (int i = 0; i <= UPROCMAX; i++)
+		if (waiters & (1 << i))
+			SYSCALL(VERHOGEN, (memaddr) &io_sem[i], 0, 0);
 }
 
 void pager(){
 	// Recupero della struttura di supporto del processo corrente
 	support_t *curr_support = (support_t *) SYSCALL(GETSUPPORTPTR, 0, 0, 0); 
 	// Estrazione del Cause.ExcCode
-	int cause = curr_support->sup_exceptState[PGFAULTEXCEPT].cause >> CAUSESHIFT; 
-	// TLB Modification, deve scattare una trap (poiche' non dovrebbe verificarsi)
-	if (cause == 1)
-		terminate(curr_support->sup_asid - 1);
+	int cause = (curr_support->sup_exceptState[PGFAULTEXCEPT].cause & GETEXECCODE) >> CAUSESHIFT; 
 	
+	int asid = curr_support->sup_asid - 1;
+	unsigned int entry_hi = curr_support->sup_exceptState[PGFAULTEXCEPT].entry_hi;
+	// L'indirizzo non appartiene all'address space del processo, deve scattare una trap
+	if (!legal_address(entry_hi))
+		terminate(asid);
+
 	// Acquisizione della mutua esclusione sulla swap pool table
 	SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0); 
 	// Aggiornamento del vettore associato alla swap pool
-	swap_pool_holding[curr_support->sup_asid - 1] = 1; 
-	// Acquisizione del numero della pagina da caricare in memoria
-	int page_missing = (curr_support->sup_exceptState[PGFAULTEXCEPT].entry_hi - KUSEG) >> VPNSHIFT; 
-
-	if ((curr_support->sup_exceptState[PGFAULTEXCEPT].entry_hi >> VPNSHIFT) == 0xBFFFF)
-		// Si tratta della pagina dello stack
-		page_missing = MAXPAGES - 1;
-
-	int victim_frame = -1; 
-	// Ciclo per trovare un frame libero nella swap_pool
-	while(++victim_frame < POOLSIZE)
-		if (swap_pool[victim_frame].sw_asid == NOPROC)
-			break; 
+	swap_pool_holding[asid] = 1; 
+	// Da qui il page fault puo' rilasciare il mutex durante l'I/O: chi elimina il processo ne attende l'uscita dal pager
+	io_state[asid].in_pager = TRUE;
+
+	// Le entry della page table del processo vengono liberate alla terminazione tramite la sua struttura di supporto
+	image_info[asid].support = curr_support;
+	// Pagina fuori dall'immagine e dallo stack (o pagina di guardia dello stack), deve scattare una trap
+	if ((entry_hi >> SHAREDSEGFLAG) != SHARED && !user_page(curr_support, KUSEGPAGE(entry_hi)))
+		terminate(asid);
+	// La entry (o la tabella di secondo livello che la contiene) potrebbe non essere ancora stata allocata
+	pteEntry_t *pte = alloc_pte(curr_support, entry_hi);
+
+	if (cause == 1){
+		// TLB Modification: e' lecita solo su una pagina copy-on-write o mappata, altrimenti deve scattare una trap
+		if (!copy_on_write(curr_support, pte) && !mmap_dirty(curr_support, pte))
+			terminate(asid);
+	} else if ((entry_hi >> SHAREDSEGFLAG) == SHARED){
+		// Pagina del segmento condiviso: viene caricata una sola volta e resta in memoria
+		if (!(pte->pte_entryLO & VALIDON))
+			map_shared_segment(curr_support, pte);
+		else {
+			// La pagina e' gia' stata caricata da un altro processo, il TLB conteneva una copia non aggiornata della entry
+			setSTATUS(getSTATUS() & DISABLEINTS);
+			refresh_TLB(pte);
+			setSTATUS(getSTATUS() | IECON);
+		}
+	} else {
+		sample_working_set(curr_support);
+		page_fault(curr_support, KUSEGPAGE(entry_hi));
+	}
+	// La decisione va presa in mutua esclusione, ma la sospensione avviene dopo aver rilasciato la swap pool
+	int suspend = admission_control(asid);
+	// Chi attende l'uscita dal pager viene svegliato; se il processo sta per essere eliminato non deve proseguire
+	io_state[asid].in_pager = FALSE;
+	io_wake(asid);
+	int doomed = io_state[asid].doomed;
 	
-	// Non è stato trovato un frame libero, si deve chiamare l'algoritmo di rimpiazzamento
-	if (victim_frame == POOLSIZE)
-		victim_frame = replacement_algorithm(); 
+	// Aggiornamento del vettore associato alla swap pool
+	swap_pool_holding[asid] = 0; 
 	
-	int frame_asid = swap_pool[victim_frame].sw_asid; 
-	// Il frame "vittima" è occupato dalla pagina di un processo
-	if (frame_asid != NOPROC){
-		// Disabilitazione degli interrupt
-		setSTATUS(getSTATUS() & DISABLEINTS); 
+	// Rilascio della mutua esclusione sulla swap pool table
+	SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
 
-		// Marcatura della page table entry come non valida
-		swap_pool[victim_frame].sw_pte->pte_entryLO &= (~VALIDON); 
-		// Aggiornamento del TLB, per garantire la coerenza dei dati andando ad aggiornare solo la entry in questione.
-		refresh_TLB(swap_pool[victim_frame].sw_pte);
+	// Il processo resta bloccato senza risorse finche' l'antenato che lo ha atteso non lo elimina dal nucleo
+	while (doomed)
+		SYSCALL(PASSEREN, (memaddr) &io_sem[asid], 0, 0);
 
-		// Riabilitazione degli interrupt
-		setSTATUS(getSTATUS() & IECON); 
-		
-		// Aggiornamento della memoria "secondaria" i.e. flash device associato al processo copiando il contenuto di in RAM del victim frame
-		flash_device_operation(victim_frame,FLASHWRITE, curr_support, (swap_pool[victim_frame].sw_pte->pte_entryHI - KUSEG) >> VPNSHIFT); 	
+	// Il processo resta sospeso finche' la somma dei working set non rientra nella swap pool
+	if (suspend)
+		SYSCALL(PASSEREN, (memaddr) &wset_sem[asid], 0, 0);
+
+	// Ritorno del controllo al processo corrente perchè la pagina è stata caricata in memoria
+	LDST(&(curr_support->sup_exceptState[PGFAULTEXCEPT])); 
+}
+
+int user_page(support_t *curr_support, int page){
+	int asid = curr_support->sup_asid - 1;
+	if (page >= stack_bottom[asid])
+		return TRUE;
+	if (page > STACKGUARDPAGE){
+		// Accesso sotto la base dello stack ma entro il limite: lo stack cresce, le nuove pagine sono azzerate al primo accesso
+		stack_bottom[asid] = page;
+		pager_stats.stack_growths++;
+		return TRUE;
 	}
+	// La pagina di guardia separa lo stack dal resto dell'address space: un accesso indica uno stack overflow
+	if (page == STACKGUARDPAGE)
+		return FALSE;
+	int dev;
+	if (mmap_block(asid, page, &dev) != -1)
+		return TRUE;
+	// Finche' l'header non e' noto non si conoscono i limiti dell'immagine
+	if (!image_info[asid].parsed || page < image_info[asid].mem_pages)
+		return TRUE;
+	// Le pagine dell'heap, come quelle di .bss, sono azzerate al primo accesso
+	return PAGEADDR(page) < heap_end[asid];
+}
+
+memaddr heap_grow(support_t *curr_support, int increment){
+	int asid = curr_support->sup_asid - 1;
+	memaddr heap_start = PAGEADDR(image_info[asid].mem_pages);
+	memaddr old_end = heap_end[asid];
+	/*
+		L'heap inizia alla prima pagina dopo .bss e puo' solo crescere: liberare pagine gia' usate
+		richiederebbe di rilasciarne frame, copie compresse e swap slot una per una.
+	*/
+	if (!image_info[asid].parsed || increment < 0)
+		return -1;
+	// Il confronto avviene sullo spazio rimasto, perche' old_end + increment potrebbe superare 2^32 e tornare sotto il limite
+	if ((unsigned int) increment > HEAPMAXPAGES * PAGESIZE - (old_end - heap_start))
+		return -1;
+	heap_end[asid] = old_end + increment;
+	return old_end;
+}
+
+memaddr mmap_region(support_t *curr_support, int dev, int block, int pages){
+	int asid = curr_support->sup_asid - 1;
+	if (pages <= 0 || pages > MMAPPAGES || block < 0)
+		return -1;
+	if (dev != MMAPDISK && (dev < 0 || dev >= DEVPERINT))
+		return -1;
+	/*
+		La regione non puo' sovrapporsi all'immagine aout all'inizio del device, letta dal pager per le pagine mai salvate,
+		ne' agli swap slot che ne occupano gli ultimi blocchi (tutto il disco, se ospita lo swap).
+	*/
+	if (block < image_area_blocks(dev) || block + pages > swap_area_start(dev))
+		return -1;
+	for (int i = 0; i < MMAPMAX; i++)
+		if (mmap_table[asid][i].pages == 0){
+			mmap_table[asid][i].dev = dev;
+			mmap_table[asid][i].block = block;
+			mmap_table[asid][i].pages = pages;
+			return PAGEADDR(MMAPBASEPAGE + i * MMAPPAGES);
+		}
+	return -1;
+}
 
-	// Lettura della pagina da caricare e scrittura in RAM nel victim frame
-	flash_device_operation(victim_frame, FLASHREAD, curr_support, page_missing); 
+int mmap_block(int asid, int page, int *dev){
+	int region = (page - MMAPBASEPAGE) / MMAPPAGES;
+	if (page < MMAPBASEPAGE || region >= MMAPMAX || (page - MMAPBASEPAGE) % MMAPPAGES >= mmap_table[asid][region].pages)
+		return -1;
+	*dev = mmap_table[asid][region].dev;
+	return mmap_table[asid][region].block + (page - MMAPBASEPAGE) % MMAPPAGES;
+}
+
+void mmap_operation(int frame, int write, support_t *curr_support, int asid, int page){
+	int dev, block = mmap_block(asid, page, &dev);
+	pager_io(curr_support, frame, write, dev, block, asid, page);
+}
+
+int mmap_dirty(support_t *curr_support, pteEntry_t *pte){
+	int asid = curr_support->sup_asid - 1, dev;
+	int page = KUSEGPAGE(pte->pte_entryHI);
+	if ((pte->pte_entryHI >> SHAREDSEGFLAG) == SHARED || mmap_block(asid, page, &dev) == -1)
+		return FALSE;
+	int frame = resident_frame(curr_support, page);
+	if (frame == -1 || !(pte->pte_entryLO & VALIDON))
+		return FALSE;
+	// Da qui in poi la pagina e' scrivibile e, quando viene rimpiazzata, deve essere riscritta sul device
+	swap_pool[frame].sw_flags |= SW_DIRTY;
+	map_frame(curr_support, page, frame, VALIDON);
+	return TRUE;
+}
+
+void page_fault(support_t *curr_support, int page_missing){
+	int asid = curr_support->sup_asid - 1;
+	int frame;
+	// Una pagina che un altro processo sta salvando si puo' rileggere solo a scrittura completata
+	wait_page_io(asid, page_missing);
+	if (is_shared_text(asid, page_missing)){
+		// Le pagine di .text sono condivise tra tutti i processi che eseguono la stessa immagine
+		frame = cache_lookup(image_info[asid].image_id, page_missing);
+		if (frame == -1){
+			pager_stats.misses++;
+			// Rimpiazzamento e lettura avvengono fuori dalla mutua esclusione, se il fault e' servito dal pager
+			io_state[asid].unlock = io_state[asid].in_pager;
+			frame = get_frame(curr_support);
+			image_read(frame, curr_support, asid, page_missing);
+			io_state[asid].unlock = FALSE;
+			// Nel frattempo un altro processo che esegue la stessa immagine potrebbe aver letto la pagina
+			int cached = cache_lookup(image_info[asid].image_id, page_missing);
+			if (cached == -1)
+				cache_insert(frame, image_info[asid].image_id, page_missing);
+			else {
+				release_frame(frame);
+				frame = cached;
+			}
+		} else if (swap_pool[frame].sw_flags & SW_PREFETCHED){
+			pager_stats.prefetch_hits++;
+			swap_pool[frame].sw_flags &= ~SW_PREFETCHED;
+		} else
+			pager_stats.cache_hits++;
+		map_shared(curr_support, page_missing, frame);
+		prefetch(curr_support, page_missing);
+	} else if ((frame = resident_frame(curr_support, page_missing)) != -1){
+		// La pagina e' gia' in memoria (caricata in anticipo o invalidata dal campionamento): basta renderla valida, senza I/O
+		if (swap_pool[frame].sw_flags & SW_PREFETCHED)
+			pager_stats.prefetch_hits++;
+		else
+			pager_stats.ref_faults++;
+		swap_pool[frame].sw_flags &= ~SW_PREFETCHED;
+		map_frame(curr_support, page_missing, frame, VALIDON);
+	} else {
+		io_state[asid].unlock = io_state[asid].in_pager;
+		frame = get_frame(curr_support);
+		if (is_demand_zero(asid, page_missing)){
+			// Pagina di .bss o di stack mai salvata sul flash device: basta azzerare il frame, senza I/O
+			pager_stats.zero_fills++;
+			zero_frame(frame);
+		} else {
+			// Lettura della pagina da caricare (dal tier compresso o dal flash device) e scrittura in RAM nel victim frame
+			swap_in(frame, curr_support, asid, page_missing);
+		}
+		io_state[asid].unlock = FALSE;
+		if (swap_pool[frame].sw_asid == PAGECACHE)
+			map_shared(curr_support, page_missing, frame);
+		else
+			map_frame(curr_support, page_missing, frame, VALIDON);
+		// Lettura anticipata delle pagine successive, se l'accesso segue un pattern regolare
+		prefetch(curr_support, page_missing);
+	}
+	// L'ultima pagina acceduta serve per riconoscere i pattern sequenziali, anche quando il fault e' stato evitato
+	prefetch_state[asid].last_page = page_missing;
+}
+
+int copy_on_write(support_t *curr_support, pteEntry_t *pte){
+	int frame = pfn_frame(pte->pte_entryLO);
+	if (frame == -1 || !(pte->pte_entryLO & VALIDON) || swap_pool[frame].sw_asid != COWFRAME)
+		return FALSE;
+	int page = KUSEGPAGE(pte->pte_entryHI);
+
+	int asid = curr_support->sup_asid - 1;
+
+	if (swap_pool[frame].sw_refcnt == 1){
+		// Il processo e' l'unico a mappare il frame, che diventa privato senza bisogno di copiarlo
+		unshare_frame(asid, frame);
+		swap_pool[frame].sw_asid = NOPROC;
+		map_frame(curr_support, page, frame, VALIDON);
+		return TRUE;
+	}
+
+	// Il frame condiviso non deve essere scelto come vittima mentre se ne cerca uno per la copia
+	pin_frame(frame);
+	int copy = get_frame(curr_support);
+	unpin_frame(frame);
+
+	unsigned int *src = (unsigned int *) FRAMEADDR(frame);
+	unsigned int *dst = (unsigned int *) FRAMEADDR(copy);
+	for (int i = 0; i < PAGESIZE / WORDLEN; i++)
+		dst[i] = src[i];
+	unshare_frame(asid, frame);
+	pager_stats.cow_copies++;
+
+	// La copia privata e' accessibile anche in scrittura
+	map_frame(curr_support, page, copy, VALIDON);
+	return TRUE;
+}
+
+void vm_fork(support_t *parent, support_t *child){
+	int parent_asid = parent->sup_asid - 1;
+	int child_asid = child->sup_asid - 1;
+
+	// Il figlio esegue la stessa immagine del padre, letta dallo stesso flash device
+	image_info[child_asid] = image_info[parent_asid];
+	image_info[child_asid].support = child;
+	prefetch_state[child_asid].last_page = -1;
+	prefetch_state[child_asid].stride = 0;
+	prefetch_state[child_asid].window = 0;
+	reset_working_set(child_asid);
+	pinned_pages[child_asid] = 0;
+	// Il figlio eredita lo stack del padre, con la stessa estensione
+	stack_bottom[child_asid] = stack_bottom[parent_asid];
+	heap_end[child_asid] = heap_end[parent_asid];
+	for (int i = 0; i < MMAPMAX; i++)
+		mmap_table[child_asid][i].pages = 0;
+	zswap_drop_asid(child_asid);
+	free_swap_slots(child_asid);
+
+	// Si scorrono solo le entry allocate dal padre: le pagine mai toccate restano demand-zero anche per il figlio
+	int cursor = 0;
+	pteEntry_t *parent_pte;
+	while ((parent_pte = next_pte(parent, &cursor)) != NULL){
+		int page = KUSEGPAGE(parent_pte->pte_entryHI);
+		// Le pagine di .text condivise vengono recuperate dalla page cache al primo accesso del figlio, le regioni mappate non vengono ereditate
+		int dev;
+		if (is_shared_text(parent_asid, page) || mmap_block(parent_asid, page, &dev) != -1)
+			continue;
+
+		int frame = resident_frame(parent, page);
+		if (frame == -1 && (parent_pte->pte_entryLO & VALIDON))
+			// La pagina e' gia' condivisa copy-on-write con un altro processo
+			frame = pfn_frame(parent_pte->pte_entryLO);
+		if (frame == -1){
+			/*
+				Una pagina mai salvata si trova ancora nell'immagine (o e' demand-zero), che non viene sovrascritta:
+				il figlio la carichera' da li' al primo accesso, senza I/O al momento della FORK.
+			*/
+			if (!zswap_contains(parent_asid, page) && swap_slot(parent_asid, page, &dev) == -1)
+				continue;
+			// Lo swap slot e la copia compressa sono del padre, che li riusera' per le versioni successive della pagina
+			frame = get_frame(parent);
+			swap_in(frame, parent, parent_asid, page);
+			map_frame(parent, page, frame, VALIDON);
+		}
+
+		// Il frame resta bloccato mentre si alloca la entry del figlio, che potrebbe richiedere un frame della swap pool
+		int pinned = swap_pool[frame].sw_flags & SW_PINNED;
+		pin_frame(frame);
+		pteEntry_t *child_pte = alloc_pte(child, PAGEADDR(page));
+		if (!pinned)
+			unpin_frame(frame);
+
+		if (pinned){
+			// Una pagina bloccata dal padre deve restare privata: il figlio ne riceve subito una copia
+			int copy = get_frame(parent);
+			unsigned int *src = (unsigned int *) FRAMEADDR(frame);
+			unsigned int *dst = (unsigned int *) FRAMEADDR(copy);
+			for (int i = 0; i < PAGESIZE / WORDLEN; i++)
+				dst[i] = src[i];
+			pager_stats.cow_copies++;
+			map_frame(child, page, copy, VALIDON);
+			continue;
+		}
+
+		if (swap_pool[frame].sw_asid != COWFRAME){
+			// Il frame privato del padre diventa condiviso
+			list_del(&(swap_pool[frame].sw_list));
+			wset[parent_asid].resident--;
+			swap_pool[frame].sw_asid = COWFRAME;
+			swap_pool[frame].sw_pageNo = page;
+			swap_pool[frame].sw_pte = NULL;
+			swap_pool[frame].sw_flags = 0;
+			swap_pool[frame].sw_refcnt = 0;
+			share_frame(parent_asid, frame);
+		}
+		share_frame(child_asid, frame);
+
+		setSTATUS(getSTATUS() & DISABLEINTS);
+		// Padre e figlio mappano il frame in sola lettura: la prima scrittura causa una TLB Modification
+		parent_pte->pte_entryLO = FRAMEADDR(frame) | VALIDON;
+		refresh_TLB(parent_pte);
+		child_pte->pte_entryLO = FRAMEADDR(frame) | VALIDON;
+		setSTATUS(getSTATUS() | IECON);
+	}
+}
+
+int pin_pages(support_t *curr_support, memaddr start, unsigned int len){
+	int asid = curr_support->sup_asid - 1;
+	// Frame bloccati da questa chiamata, da sbloccare se l'intervallo non puo' essere bloccato per intero
+	int pinned_now[PINMAX];
+	int count = 0;
+
+	for (memaddr addr = start & ~(PAGESIZE - 1); addr < start + len; addr += PAGESIZE){
+		pteEntry_t *pte = NULL;
+		// Come nel pager, le pagine fuori dall'immagine e dallo stack non possono essere bloccate
+		if (legal_address(addr) && ((addr >> SHAREDSEGFLAG) == SHARED || user_page(curr_support, KUSEGPAGE(addr))))
+			pte = alloc_pte(curr_support, addr);
+		if (pte != NULL && (addr >> SHAREDSEGFLAG) == SHARED){
+			// Le pagine del segmento condiviso restano comunque in memoria una volta caricate
+			if (!(pte->pte_entryLO & VALIDON))
+				map_shared_segment(curr_support, pte);
+			continue;
+		}
+		int page = (pte == NULL) ? -1 : KUSEGPAGE(addr);
+		int frame = (pte == NULL) ? -1 : resident_frame(curr_support, page);
+		if (frame != -1 && (swap_pool[frame].sw_flags & SW_PINNED))
+			continue;
+
+		/*
+			Oltre al limite del processo, almeno meta' della swap pool deve restare rimpiazzabile, altrimenti i page fault
+			degli altri processi non potrebbero essere serviti. Contano tutti i frame bloccati, non solo quelli di SYS7:
+			anche le tabelle di secondo livello (allocate pure da questo ciclo) e le pagine del segmento condiviso.
+		*/
+		if (pte != NULL && pinned_pages[asid] < PINMAX && pinned_frames() < swap_pool_size / 2 && !is_shared_text(asid, page)){
+			// La pagina viene caricata subito e, se condivisa copy-on-write, resa privata
+			if ((pte->pte_entryLO & VALIDON) && frame == -1)
+				copy_on_write(curr_support, pte);
+			else if (!(pte->pte_entryLO & VALIDON))
+				page_fault(curr_support, page);
+			// La prima pagina dell'immagine potrebbe essere finita nella page cache
+			frame = resident_frame(curr_support, page);
+		} else
+			frame = -1;
+
+		if (frame == -1){
+			while (count > 0){
+				unpin_frame(pinned_now[--count]);
+				pinned_pages[asid]--;
+			}
+			return FALSE;
+		}
+		pin_frame(frame);
+		swap_pool[frame].sw_flags &= ~SW_PREFETCHED;
+		pinned_now[count++] = frame;
+		pinned_pages[asid]++;
+	}
+	return TRUE;
+}
+
+void unpin_pages(support_t *curr_support, memaddr start, unsigned int len){
+	int asid = curr_support->sup_asid - 1;
+	for (memaddr addr = start & ~(PAGESIZE - 1); addr < start + len; addr += PAGESIZE){
+		pteEntry_t *pte = get_pte(curr_support, addr);
+		if (pte == NULL || (addr >> SHAREDSEGFLAG) == SHARED)
+			continue;
+		int frame = resident_frame(curr_support, KUSEGPAGE(addr));
+		if (frame != -1 && (swap_pool[frame].sw_flags & SW_PINNED)){
+			unpin_frame(frame);
+			pinned_pages[asid]--;
+		}
+	}
+}
+
+void map_shared_segment(support_t *curr_support, pteEntry_t *pte){
+	int frame = get_frame(curr_support);
+	// Il segmento condiviso non ha backing store: parte azzerato e i suoi frame non vengono mai rimpiazzati
+	zero_frame(frame);
+	swap_pool[frame].sw_asid = SHAREDSEG;
+	swap_pool[frame].sw_pageNo = pte - shared_pgTbl;
+	swap_pool[frame].sw_pte = pte;
+	swap_pool[frame].sw_flags = 0;
+	pin_frame(frame);
+	pager_stats.zero_fills++;
+
+	// Disabilitazione degli interrupt
+	setSTATUS(getSTATUS() & DISABLEINTS);
+	// Una sola entry del TLB, con il bit G acceso, serve tutti gli ASID
+	pte->pte_entryLO = FRAMEADDR(frame) | VALIDON | DIRTYON | GLOBALON;
+	refresh_TLB(pte);
+	// Riabilitazione degli interrupt
+	setSTATUS(getSTATUS() | IECON);
+}
+
+int pfn_frame(unsigned int entry_lo){
+	memaddr frame_addr = entry_lo & ENTRYLO_PFN_MASK;
+	if (frame_addr < swap_pool_start || frame_addr >= FRAMEADDR(swap_pool_size))
+		return -1;
+	return (frame_addr - swap_pool_start) / PAGESIZE;
+}
+
+int resident_frame(support_t *curr_support, int page){
+	pteEntry_t *pte = page_pte(curr_support, page);
+	if (pte == NULL)
+		return -1;
+	// Anche se la entry non e' valida, il campo PFN conserva l'ultimo frame assegnato alla pagina
+	int frame = pfn_frame(pte->pte_entryLO);
+	if (frame == -1)
+		return -1;
+	// Il frame potrebbe essere stato nel frattempo assegnato ad un'altra pagina
+	if (swap_pool[frame].sw_asid != curr_support->sup_asid - 1 || swap_pool[frame].sw_pageNo != page)
+		return -1;
+	return frame;
+}
+
+int get_frame(support_t *curr_support){
+	// Estrazione in tempo costante di un frame dalla lista dei frame liberi
+	int victim_frame = alloc_frame(); 
 	
+	// Non è stato trovato un frame libero, si deve chiamare l'algoritmo di rimpiazzamento
+	if (victim_frame == -1){
+		int asid = curr_support->sup_asid - 1;
+		// Un processo oltre la propria quota rimpiazza prima le proprie pagine, senza sottrarre frame agli altri
+		if (wset[asid].resident >= wset[asid].quota && (victim_frame = local_victim(asid)) != -1)
+			pager_stats.local_evictions++;
+		else
+			victim_frame = replacement_algorithm(); 
+		// Tutti i frame sono bloccati in memoria, non e' possibile servire il page fault
+		if (victim_frame == -1)
+			terminate(curr_support->sup_asid - 1);
+		swap_pool[victim_frame].sw_flags |= SW_BUSY;
+		evict_frame(victim_frame, curr_support);
+	}
+	// Il frame resta in transito finche' non viene assegnato, anche mentre il mutex e' rilasciato per l'I/O
+	swap_pool[victim_frame].sw_flags |= SW_BUSY;
+	return victim_frame;
+}
+
+void evict_frame(int victim_frame, support_t *curr_support){
+	if (swap_pool[victim_frame].sw_asid == COWFRAME){
+		evict_cow_frame(victim_frame, curr_support);
+		return;
+	}
+	if (swap_pool[victim_frame].sw_asid == PAGECACHE){
+		// Le pagine condivise sono in sola lettura, non c'e' bisogno di salvarle sul flash device
+		if (swap_pool[victim_frame].sw_flags & SW_PREFETCHED)
+			pager_stats.prefetch_wasted++;
+		cache_remove(victim_frame);
+		swap_pool[victim_frame].sw_asid = NOPROC;
+		swap_pool[victim_frame].sw_flags = 0;
+		return;
+	}
+#if BACKINGSTORE == DISKBACK
+	evict_cluster(victim_frame, curr_support);
+#else
+	evict_private_frame(victim_frame, curr_support);
+#endif
+}
+
+void evict_private_frame(int victim_frame, support_t *curr_support){
+	int owner = swap_pool[victim_frame].sw_asid;
+	int page = swap_pool[victim_frame].sw_pageNo;
+	int flags = swap_pool[victim_frame].sw_flags;
+
+	// Disabilitazione degli interrupt
+	setSTATUS(getSTATUS() & DISABLEINTS); 
+
+	// Marcatura della page table entry come non valida
+	swap_pool[victim_frame].sw_pte->pte_entryLO &= (~VALIDON); 
+	// Aggiornamento del TLB, per garantire la coerenza dei dati andando ad aggiornare solo la entry in questione.
+	refresh_TLB(swap_pool[victim_frame].sw_pte);
+
+	// Riabilitazione degli interrupt
+	setSTATUS(getSTATUS() | IECON); 
+
+	/*
+		Il frame non appartiene piu' all'insieme dei frame residenti del vecchio proprietario gia' prima del salvataggio,
+		che puo' avvenire fuori dalla mutua esclusione: durante la scrittura il frame e' in transito (SW_BUSY).
+	*/
+	list_del(&(swap_pool[victim_frame].sw_list));
+	wset[owner].resident--;
+	swap_pool[victim_frame].sw_asid = NOPROC;
+	swap_pool[victim_frame].sw_flags = flags & (SW_BUSY | SW_DIRTY);
+	
+	if (flags & SW_PREFETCHED)
+		// La pagina caricata in anticipo non e' mai stata usata, e' identica alla copia sul flash device
+		prefetch_wasted(owner);
+	else {
+		// Aggiornamento della memoria "secondaria" (tier compresso o flash device del processo) copiando il contenuto in RAM del victim frame
+		swap_out(victim_frame, curr_support, owner, page);
+	}
+	swap_pool[victim_frame].sw_flags &= SW_BUSY;
+}
+
+void evict_cluster(int victim_frame, support_t *curr_support){
+	int owner = swap_pool[victim_frame].sw_asid;
+	int first = swap_pool[victim_frame].sw_pageNo - (swap_pool[victim_frame].sw_pageNo % SWAPCLUSTER);
+	support_t *owner_support = image_info[owner].support;
+	if (owner_support == NULL){
+		evict_private_frame(victim_frame, curr_support);
+		return;
+	}
+
+	// Le pagine vicine non sono in transito: il cluster viene salvato in mutua esclusione sulla swap pool
+	int me = curr_support->sup_asid - 1;
+	int unlock = io_state[me].unlock;
+	io_state[me].unlock = FALSE;
+	// Le pagine vengono salvate in ordine crescente, quindi in settori consecutivi dello stesso cilindro
+	for (int page = first; page < first + SWAPCLUSTER && page < KUSEGPAGES; page++){
+		int frame = resident_frame(owner_support, page);
+		if (frame != victim_frame && (frame == -1 || (swap_pool[frame].sw_flags & (SW_PINNED | SW_REFERENCED | SW_PREFETCHED))))
+			continue;
+		evict_private_frame(frame, curr_support);
+		// Le pagine vicine rimpiazzate insieme alla vittima tornano tra i frame liberi
+		if (frame != victim_frame){
+			release_frame(frame);
+			pager_stats.cluster_evictions++;
+		}
+	}
+	io_state[me].unlock = unlock;
+}
+
+void cluster_read_ahead(support_t *curr_support, int page){
+	int asid = curr_support->sup_asid - 1;
+	int dev;
+	// I frame liberi usati per la lettura anticipata non sono in transito: le letture avvengono in mutua esclusione
+	int unlock = io_state[asid].unlock;
+	io_state[asid].unlock = FALSE;
+	for (int next_page = page + 1; next_page < KUSEGPAGES && next_page % SWAPCLUSTER != 0; next_page++){
+		// Solo le pagine salvate nel cluster, non residenti e non nel tier compresso
+		if (swap_slot(asid, next_page, &dev) == -1 || dev != SWAPDISK)
+			continue;
+		pteEntry_t *pte = page_pte(curr_support, next_page);
+		if (pte == NULL || (pte->pte_entryLO & VALIDON) || resident_frame(curr_support, next_page) != -1 || zswap_contains(asid, next_page))
+			continue;
+		// Come per la lettura anticipata dal flash device, si usano solo frame liberi
+		int frame = alloc_frame();
+		if (frame == -1)
+			break;
+		swap_read(frame, curr_support, asid, next_page);
+		map_frame(curr_support, next_page, frame, 0);
+		swap_pool[frame].sw_flags |= SW_PREFETCHED;
+		pager_stats.prefetched++;
+	}
+	io_state[asid].unlock = unlock;
+}
+
+void evict_cow_frame(int victim_frame, support_t *curr_support){
+	int page = swap_pool[victim_frame].sw_pageNo;
+	// Il frame resta mappato dai processi non ancora serviti: le copie vengono salvate in mutua esclusione
+	int me = curr_support->sup_asid - 1;
+	int unlock = io_state[me].unlock;
+	io_state[me].unlock = FALSE;
+
+	// Ogni processo che mappa il frame ne riceve una copia sul proprio flash device
+	for (int asid = 0; asid < UPROCMAX && swap_pool[victim_frame].sw_refcnt > 0; asid++){
+		if (!maps_shared(asid, victim_frame))
+			continue;
+		pteEntry_t *pte = page_pte(image_info[asid].support, page);
+
+		setSTATUS(getSTATUS() & DISABLEINTS); 
+		pte->pte_entryLO &= (~VALIDON); 
+		refresh_TLB(pte);
+		setSTATUS(getSTATUS() | IECON); 
+
+		swap_out(victim_frame, curr_support, asid, page);
+		unshare_frame(asid, victim_frame);
+	}
+	io_state[me].unlock = unlock;
+	swap_pool[victim_frame].sw_asid = NOPROC;
+	swap_pool[victim_frame].sw_flags = 0;
+	swap_pool[victim_frame].sw_refcnt = 0;
+}
+
+void map_frame(support_t *curr_support, int page, int frame, unsigned int valid){
+	int asid = curr_support->sup_asid - 1;
+	pteEntry_t *pte = page_pte(curr_support, page);
+
 	// Disabilitazione degli interrupt
 	setSTATUS(getSTATUS() & DISABLEINTS);
 
 	// Aggiornamento della tabella della swap pool ai nuovi dati che occupano il frame 
-	swap_pool[victim_frame].sw_asid = curr_support->sup_asid - 1; 
-	swap_pool[victim_frame].sw_pageNo = page_missing; 
-	swap_pool[victim_frame].sw_pte = &(curr_support->sup_privatePgTbl[page_missing]);
+	if (swap_pool[frame].sw_asid == NOPROC){
+		swap_pool[frame].sw_flags &= ~SW_BUSY;
+		swap_pool[frame].sw_asid = asid; 
+		swap_pool[frame].sw_pageNo = page; 
+		swap_pool[frame].sw_pte = pte;
+		list_add_tail(&(swap_pool[frame].sw_list), &swap_asid_h[asid]);
+		wset[asid].resident++;
+	}
+	// Una pagina resa valida conta come accesso per la stima del working set
+	if (valid)
+		swap_pool[frame].sw_flags |= SW_REFERENCED;
 
-	// Aggiornamento della tabella delle pagine, ora la pagina si trova in memoria (bit V a 1)
-	curr_support->sup_privatePgTbl[page_missing].pte_entryLO = (POOLSTART + (victim_frame * PAGESIZE)) | VALIDON | DIRTYON; 
+	// Le pagine mappate restano in sola lettura finche' non vengono modificate, cosi' quelle pulite non vengono riscritte sul device
+	int dev;
+	unsigned int dirty = (mmap_block(asid, page, &dev) == -1 || (swap_pool[frame].sw_flags & SW_DIRTY)) ? DIRTYON : 0;
+	// Aggiornamento della tabella delle pagine, il bit V e' acceso solo se la pagina deve essere subito accessibile
+	pte->pte_entryLO = FRAMEADDR(frame) | valid | dirty; 
 
 	// Aggiornamento del TLB, per garantire la coerenza dei dati andando ad aggiornare solo la entry in questione.
-	refresh_TLB(&curr_support->sup_privatePgTbl[page_missing]);
+	refresh_TLB(pte);
 
 	// Riabilitazione degli interrupt
-	setSTATUS(getSTATUS() & IECON);
-	
-	// Aggiornamento del vettore associato alla swap pool
-	swap_pool_holding[curr_support->sup_asid - 1] = 0; 
-	
-	// Rilascio della mutua esclusione sulla swap pool table
-	SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0); 
+	setSTATUS(getSTATUS() | IECON);
+}
 
-	// Ritorno del controllo al processo corrente perchè la pagina è stata caricata in memoria
-	LDST(&(curr_support->sup_exceptState[PGFAULTEXCEPT])); 
+void prefetch(support_t *curr_support, int page){
+	int asid = curr_support->sup_asid - 1;
+	prefetch_t *state = &prefetch_state[asid];
+	int stride = page - state->last_page;
+
+	if (stride != 0 && stride == state->stride)
+		// Il pattern e' confermato, la finestra di lettura anticipata viene allargata
+		state->window = state->window == 0 ? 1 : MIN(state->window * 2, PREFETCHMAX);
+	else {
+		// Nuovo pattern: si attende una conferma prima di leggere in anticipo
+		state->stride = stride;
+		state->window = 0;
+	}
+
+	// Solo le pagine di .text/.data presenti sul device dell'immagine possono essere lette in anticipo
+	int last_page = image_blocks(asid);
+	if (image_info[asid].parsed)
+		last_page = MIN(last_page, image_info[asid].file_pages);
+	for (int i = 1; i <= state->window; i++){
+		int next_page = page + i * state->stride;
+		if (next_page < 0 || next_page >= last_page)
+			break;
+		int shared = is_shared_text(asid, next_page);
+		// Le pagine la cui tabella di secondo livello non e' allocata non vengono lette in anticipo
+		pteEntry_t *pte = page_pte(curr_support, next_page);
+		if (pte == NULL || (pte->pte_entryLO & VALIDON))
+			continue;
+		if (shared ? cache_lookup(image_info[asid].image_id, next_page) != -1 : resident_frame(curr_support, next_page) != -1)
+			continue;
+		// La copia sul flash device di una pagina nel tier compresso non e' aggiornata, e il fault costa comunque poco
+		if (!shared && zswap_contains(asid, next_page))
+			continue;
+		// La lettura anticipata usa solo frame liberi, senza mai sottrarli ad altre pagine
+		int frame = alloc_frame();
+		if (frame == -1)
+			break;
+		// Le pagine gia' salvate si leggono dal loro swap slot, le altre dall'immagine
+		if (shared || !swap_read(frame, curr_support, asid, next_page))
+			image_read(frame, curr_support, asid, next_page);
+		if (shared)
+			// La pagina resta nella page cache finche' un processo non la accede
+			cache_insert(frame, image_info[asid].image_id, next_page);
+		else
+			map_frame(curr_support, next_page, frame, 0);
+		swap_pool[frame].sw_flags |= SW_PREFETCHED;
+		pager_stats.prefetched++;
+	}
+}
+
+void prefetch_wasted(int asid){
+	pager_stats.prefetch_wasted++;
+	// Le pagine lette in anticipo non vengono usate, la finestra si restringe
+	prefetch_state[asid].window /= 2;
+}
+
+int aout_file_pages(memaddr header){
+	memaddr text_end = *((memaddr *) (header + AOUT_TEXTVADDR)) + *((memaddr *) (header + AOUT_TEXTFILESZ));
+	memaddr data_end = *((memaddr *) (header + AOUT_DATAVADDR)) + *((memaddr *) (header + AOUT_DATAFILESZ));
+	// Le immagini dei U-proc sono collegate a partire da KUSEG
+	if (*((memaddr *) (header + AOUT_TAG)) != AOUTFILEID || *((memaddr *) (header + AOUT_TEXTVADDR)) != KUSEG || text_end < KUSEG || data_end < KUSEG)
+		return -1;
+	// La parte file-backed dell'immagine termina con l'ultimo byte di .text o .data presente nel file
+	return (MAX(text_end, data_end) - KUSEG + PAGESIZE - 1) / PAGESIZE;
+}
+
+void parse_aout_header(support_t *curr_support, int frame){
+	int asid = curr_support->sup_asid - 1;
+	memaddr header = FRAMEADDR(frame);
+	memaddr text_end = *((memaddr *) (header + AOUT_TEXTVADDR)) + *((memaddr *) (header + AOUT_TEXTFILESZ));
+	memaddr data_start = *((memaddr *) (header + AOUT_DATAVADDR));
+	// In memoria l'immagine si estende fino alla fine di .bss
+	memaddr mem_end = MAX(*((memaddr *) (header + AOUT_TEXTVADDR)) + *((memaddr *) (header + AOUT_TEXTMEMSZ)), data_start + *((memaddr *) (header + AOUT_DATAMEMSZ)));
+
+	image_info[asid].file_pages = aout_file_pages(header);
+	image_info[asid].mem_pages = (mem_end - KUSEG + PAGESIZE - 1) / PAGESIZE;
+	// L'heap e' inizialmente vuoto e inizia alla pagina successiva all'immagine
+	heap_end[asid] = PAGEADDR(image_info[asid].mem_pages);
+	// Sono condivisibili solo le pagine di .text che non contengono anche dati modificabili
+	image_info[asid].text_pages = (text_end - KUSEG + PAGESIZE - 1) / PAGESIZE;
+	if (*((memaddr *) (header + AOUT_DATAMEMSZ)) > 0)
+		image_info[asid].text_pages = MIN(image_info[asid].text_pages, (int) ((data_start - KUSEG) / PAGESIZE));
+
+	image_info[asid].support = curr_support;
+	image_info[asid].parsed = 1;
+}
+
+void image_written(int dev, int block){
+	// Le pagine gia' in cache con la vecchia identita' non vengono piu' trovate e vengono rimpiazzate come le altre
+	if (block >= image_area_blocks(dev))
+		return;
+	/*
+		Anche gli altri device con lo stesso contenuto ricalcolano la loro identita' al prossimo caricamento, perche' i processi
+		gia' avviati da dev leggono d'ora in poi il nuovo contenuto sotto la vecchia identita'.
+	*/
+	unsigned int old_id = IMAGEID(dev, image_gen[dev]);
+	for (int other = 0; other <= DEVPERINT; other++)
+		if (image_ident[other] == old_id)
+			ident_gen[other] = 0;
+	image_gen[dev]++;
+}
+
+// Calcola in *hash l'hash dei blocchi dell'immagine del device dev, ritorna -1 se un blocco non e' leggibile
+HIDDEN int hash_image(int dev, unsigned int *hash){
+	unsigned int *word = (unsigned int *) FRAMEADDR(scratch_frame);
+	*hash = 2166136261U;
+	for (int block = 0; block < image_area_blocks(dev); block++){
+		if (device_transfer(scratch_frame, FALSE, dev, block) != READY)
+			return -1;
+		for (int i = 0; i < PAGESIZE / WORDLEN; i++)
+			*hash = (*hash ^ word[i]) * 16777619U;
+	}
+	return 0;
+}
+
+// Confronta blocco per blocco le immagini dei device dev e other, ritorna TRUE se identiche e -1 se un blocco non e' leggibile
+HIDDEN int same_image(int dev, int other){
+	unsigned int *word = (unsigned int *) FRAMEADDR(scratch_frame), *other_word = (unsigned int *) FRAMEADDR(scratch_frame + 1);
+	for (int block = 0; block < image_area_blocks(dev); block++){
+		if (device_transfer(scratch_frame, FALSE, dev, block) != READY || device_transfer(scratch_frame + 1, FALSE, other, block) != READY)
+			return -1;
+		for (int i = 0; i < PAGESIZE / WORDLEN; i++)
+			if (word[i] != other_word[i])
+				return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+	Ritorna l'identita' del contenuto attuale dell'immagine del device dev: quella di un altro device se le immagini coincidono,
+	altrimenti una nuova. Un hash uguale non basta, l'uguaglianza viene confermata confrontando tutti i blocchi.
+*/
+HIDDEN unsigned int image_identity(int dev){
+	if (ident_gen[dev] == image_gen[dev] + 1)
+		return image_ident[dev];
+	unsigned int id = IMAGEID(dev, image_gen[dev]);
+	// Se un blocco non e' leggibile l'identita' resta propria del device, e viene ricalcolata al prossimo caricamento
+	if (hash_image(dev, &image_hash[dev]) == -1)
+		return id;
+	for (int other = 0; other <= DEVPERINT; other++){
+		if (other == dev || ident_gen[other] != image_gen[other] + 1 || image_hash[other] != image_hash[dev] || image_area_blocks(other) != image_area_blocks(dev))
+			continue;
+		int same = same_image(dev, other);
+		if (same == -1)
+			return id;
+		if (same){
+			id = image_ident[other];
+			break;
+		}
+	}
+	image_ident[dev] = id;
+	ident_gen[dev] = image_gen[dev] + 1;
+	return id;
+}
+
+int is_shared_text(int asid, int page){
+	return image_info[asid].parsed && page < image_info[asid].text_pages;
+}
+
+int cache_lookup(unsigned int image_id, int page){
+	struct list_head *bucket = &page_cache_h[(image_id + page) % PAGECACHESIZE];
+	swap_t *iter;
+	list_for_each_entry(iter, bucket, sw_list){
+		if (iter->sw_image == image_id && iter->sw_pageNo == page)
+			return iter - swap_pool;
+	}
+	return -1;
+}
+
+void cache_insert(int frame, unsigned int image_id, int page){
+	swap_pool[frame].sw_asid = PAGECACHE;
+	swap_pool[frame].sw_flags &= ~SW_BUSY;
+	swap_pool[frame].sw_image = image_id;
+	swap_pool[frame].sw_pageNo = page;
+	swap_pool[frame].sw_refcnt = 0;
+	swap_pool[frame].sw_pte = NULL;
+	list_add_tail(&(swap_pool[frame].sw_list), &page_cache_h[(image_id + page) % PAGECACHESIZE]);
+}
+
+void cache_remove(int frame){
+	int page = swap_pool[frame].sw_pageNo;
+
+	// Disabilitazione degli interrupt
+	setSTATUS(getSTATUS() & DISABLEINTS);
+	// Tutti i processi che eseguono la stessa immagine potrebbero aver mappato il frame
+	for (int asid = 0; asid < UPROCMAX && swap_pool[frame].sw_refcnt > 0; asid++){
+		if (!maps_shared(asid, frame))
+			continue;
+		pteEntry_t *pte = page_pte(image_info[asid].support, page);
+		pte->pte_entryLO &= ~VALIDON;
+		refresh_TLB(pte);
+		unshare_frame(asid, frame);
+	}
+	// Riabilitazione degli interrupt
+	setSTATUS(getSTATUS() | IECON);
+
+	list_del(&(swap_pool[frame].sw_list));
+}
+
+void map_shared(support_t *curr_support, int page, int frame){
+	pteEntry_t *pte = page_pte(curr_support, page);
+
+	// Disabilitazione degli interrupt
+	setSTATUS(getSTATUS() & DISABLEINTS);
+
+	if (!maps_shared(curr_support->sup_asid - 1, frame))
+		share_frame(curr_support->sup_asid - 1, frame);
+	// Il bit D e' spento: la pagina condivisa e' accessibile in sola lettura
+	pte->pte_entryLO = FRAMEADDR(frame) | VALIDON; 
+	refresh_TLB(pte);
+
+	// Riabilitazione degli interrupt
+	setSTATUS(getSTATUS() | IECON);
+}
+
+int is_demand_zero(int asid, int page){
+	// Finche' l'header non e' noto, ogni pagina viene letta dal flash device
+	if (!image_info[asid].parsed)
+		return FALSE;
+	// Lo stato delle pagine salvate e' nelle tabelle hash del tier compresso e degli swap slot, non nella page table
+	int dev;
+	return page >= image_info[asid].file_pages && !zswap_contains(asid, page) && swap_slot(asid, page, &dev) == -1 && mmap_block(asid, page, &dev) == -1;
+}
+
+void zero_frame(int frame){
+	unsigned int *word = (unsigned int *) FRAMEADDR(frame);
+	for (int i = 0; i < PAGESIZE / WORDLEN; i++)
+		word[i] = 0;
+}
+
+void swap_out(int frame, support_t *curr_support, int asid, int page){
+	int dev;
+	// Le pagine mappate tornano al loro device, e solo se sono state modificate
+	if (mmap_block(asid, page, &dev) != -1){
+		if (swap_pool[frame].sw_flags & SW_DIRTY)
+			mmap_operation(frame, TRUE, curr_support, asid, page);
+		return;
+	}
+	// La scrittura su memoria secondaria avviene solo se il tier compresso e' pieno o la pagina incomprimibile
+	if (!zswap_store(FRAMEADDR(frame), asid, page)){
+		zswap_stats.overflows++;
+		// Lo slot e' assegnato alla prima scrittura e riusato finche' il processo non termina
+		swap_write(frame, curr_support, asid, page);
+	}
+}
+
+void swap_in(int frame, support_t *curr_support, int asid, int page){
+	int dev;
+	// Le pagine mappate si leggono direttamente dal blocco del device, senza copie intermedie
+	if (mmap_block(asid, page, &dev) != -1){
+		pager_stats.misses++;
+		mmap_operation(frame, FALSE, curr_support, asid, page);
+		return;
+	}
+	if (zswap_load(FRAMEADDR(frame), asid, page))
+		return;
+	pager_stats.misses++;
+	if (swap_read(frame, curr_support, asid, page)){
+#if BACKINGSTORE == DISKBACK
+		// La testina e' gia' sul cilindro del cluster: le pagine successive costano solo la lettura
+		cluster_read_ahead(curr_support, page);
+#endif
+		return;
+	}
+	image_read(frame, curr_support, asid, page);
+}
+
+int device_transfer(int frame, int write, int dev, int block){
+	if (dev == MMAPDISK || dev == SWAPDISK)
+		return disk_transfer(frame, write ? DISKWRITE : DISKREAD, block);
+	return flash_transfer(frame, write ? FLASHWRITE : FLASHREAD, dev, block);
+}
+
+void pager_io(support_t *curr_support, int frame, int write, int dev, int block, int owner, int page){
+	int asid = curr_support->sup_asid - 1;
+	int status;
+	if (!io_state[asid].unlock)
+		status = device_transfer(frame, write, dev, block);
+	else {
+		/*
+			Il frame e' in transito (SW_BUSY) e non appartiene a nessuna lista: mentre il device lavora gli altri processi
+			possono usare la swap pool e servire i propri page fault, anche su altri device.
+		*/
+		io_state[asid].active = TRUE;
+		io_state[asid].owner = owner;
+		io_state[asid].page = page;
+		swap_pool_holding[asid] = 0;
+		SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0);
+		status = device_transfer(frame, write, dev, block);
+		SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0);
+		swap_pool_holding[asid] = 1;
+		io_state[asid].active = FALSE;
+		io_wake(asid);
+	}
+	// Se si è verificato un errore, scatta una trap
+	if (status != READY)
+		terminate(asid);
+}
+
+int page_io_doer(int owner, int page){
+	for (int i = 0; i < UPROCMAX; i++)
+		if (io_state[i].active && io_state[i].owner == owner && (page == -1 || io_state[i].page == page))
+			return i;
+	return -1;
+}
+
+void wait_page_io(int owner, int page){
+	int doer;
+	while ((doer = page_io_doer(owner, page)) != -1)
+		wait_io(doer, FALSE);
+}
+
+int pager_busy(int asid){
+	return io_state[asid].in_pager;
+}
+
+void wait_io(int doer, int doom){
+	int self = io_self();
+	if (doom)
+		io_state[doer].doomed = TRUE;
+	// La registrazione avviene in mutua esclusione, e doer esegue una sola V per ciascuna: il semaforo non supera mai 1
+	io_state[doer].waiters |= 1 << self;
+	if (self < UPROCMAX)
+		swap_pool_holding[self] = 0;
+	SYSCALL(VERHOGEN, (memaddr) &swap_pool_semaphore, 0, 0);
+	SYSCALL(PASSEREN, (memaddr) &io_sem[self], 0, 0);
+	SYSCALL(PASSEREN, (memaddr) &swap_pool_semaphore, 0, 0);
+	if (self < UPROCMAX)
+		swap_pool_holding[self] = 1;
+}
+
+void reset_io_state(int asid){
+	io_wake(asid);
+	// Il processo eliminato dal nucleo mentre attendeva non deve ricevere altre V
+	for (int i = 0; i < UPROCMAX; i++)
+		io_state[i].waiters &= ~(1 << asid);
+	io_state[asid].in_pager = FALSE;
+	io_state[asid].unlock = FALSE;
+	io_state[asid].active = FALSE;
+	io_state[asid].doomed = FALSE;
+	io_sem[asid] = 0;
+}
+
+int image_transfer(int frame, int asid, int page){
+	// Le pagine mai salvate si leggono dal device che contiene l'immagine, la pagina i-esima dal blocco i-esimo
+	return device_transfer(frame, FALSE, image_info[asid].image_dev, page);
+}
+
+void image_read(int frame, support_t *curr_support, int asid, int page){
+	pager_io(curr_support, frame, FALSE, image_info[asid].image_dev, page, asid, page);
+}
+
+int image_blocks(int asid){
+	return image_info[asid].image_dev == MMAPDISK ? disk_blocks() : flash_blocks(image_info[asid].image_dev);
+}
+
+int vm_preload(support_t *curr_support){
+	int asid = curr_support->sup_asid - 1;
+	/*
+		Chi prepara l'U-proc detiene il mutex sulla swap pool e non e' il processo che sta caricando: il caricamento anticipato
+		usa solo frame (ed entry della page table) liberi, senza rimpiazzare ne' terminare nessuno. Se non bastano
+		si rinuncia, e il pager carichera' le pagine al primo accesso.
+	*/
+	unsigned int text = PAGEADDR(0), stack = PAGEADDR(STACKTOPPAGE);
+	int cost = pte_frames(curr_support, text);
+	if (cost == -1 || free_frames() < cost + 1)
+		return 0;
+	alloc_pte(curr_support, text);
+
+	// Una sola lettura dal device: la prima pagina contiene l'entry point (o e' gia' nella page cache)
+	int frame = cache_lookup(image_info[asid].image_id, 0);
+	if (frame == -1){
+		frame = alloc_frame();
+		if (image_transfer(frame, asid, 0) != READY){
+			release_frame(frame);
+			return -1;
+		}
+		pager_stats.misses++;
+	} else {
+		pager_stats.cache_hits++;
+		swap_pool[frame].sw_flags &= ~SW_PREFETCHED;
+	}
+	if (swap_pool[frame].sw_asid != PAGECACHE && is_shared_text(asid, 0))
+		cache_insert(frame, image_info[asid].image_id, 0);
+	if (swap_pool[frame].sw_asid == PAGECACHE)
+		map_shared(curr_support, 0, frame);
+	else
+		map_frame(curr_support, 0, frame, VALIDON);
+
+	// La pagina di stack e' demand-zero e viene solo azzerata
+	cost = pte_frames(curr_support, stack);
+	if (cost == -1 || free_frames() < cost + 1)
+		return 0;
+	alloc_pte(curr_support, stack);
+	frame = alloc_frame();
+	pager_stats.zero_fills++;
+	zero_frame(frame);
+	map_frame(curr_support, STACKTOPPAGE, frame, VALIDON);
+	return 0;
+}
+
+int vm_load(support_t *curr_support, int dev){
+	int asid = curr_support->sup_asid - 1;
+	image_info[asid].parsed = 0;
+	/*
+		L'header viene letto subito nel frame di appoggio: un device senza immagine, con un'immagine che non e' un aout
+		o non collegata a partire da KUSEG viene rifiutato prima di creare il processo.
+	*/
+	if (image_area_blocks(dev) == 0 || device_transfer(scratch_frame, FALSE, dev, 0) != READY || aout_file_pages(FRAMEADDR(scratch_frame)) == -1)
+		return -1;
+	image_info[asid].image_dev = dev;
+	parse_aout_header(curr_support, scratch_frame);
+	/*
+		Condividono le pagine di .text i processi che eseguono la stessa immagine, anche se si trova su device diversi:
+		l'identita' viene calcolata dal contenuto una volta per ogni generazione del device, riusando i frame di appoggio.
+	*/
+	image_info[asid].image_id = image_identity(dev);
+	prefetch_state[asid].last_page = -1;
+	prefetch_state[asid].stride = 0;
+	prefetch_state[asid].window = 0;
+	return 0;
+}
+
+int flash_blocks(int asid){
+	// Per i flash device il campo DATA1 contiene il numero di blocchi del device
+	devreg_t *dev_reg = (devreg_t *) (DEVREGSTRT_ADDR + ((FLASHINT - 3) * 0x80) + (asid * 0x10));
+	return dev_reg->dtp.data1;
 }
 
 // Algoritmo di rimpiazzamento FIFO
+int local_victim(int asid){
+	swap_t *iter;
+	int victim_frame = -1;
+	// La lista e' in ordine di caricamento: si sceglie la pagina piu' vecchia non acceduta di recente
+	list_for_each_entry(iter, &swap_asid_h[asid], sw_list){
+		if (iter->sw_flags & (SW_PINNED | SW_BUSY))
+			continue;
+		if (!(iter->sw_flags & SW_REFERENCED))
+			return iter - swap_pool;
+		if (victim_frame == -1)
+			victim_frame = iter - swap_pool;
+	}
+	return victim_frame;
+}
+
+void sample_working_set(support_t *curr_support){
+	int asid = curr_support->sup_asid - 1;
+	cpu_t now;
+	STCK(now);
+	if (now - wset[asid].last_sample < WSINTERVAL)
+		return;
+
+	/*
+		uMPS3 non ha un bit di riferimento hardware: le pagine accedute dall'ultimo campionamento
+		vengono contate e invalidate (conservando il PFN), cosi' il prossimo accesso causa un page fault
+		senza I/O che riaccende SW_REFERENCED.
+	*/
+	swap_t *iter;
+	int wss = 0;
+	setSTATUS(getSTATUS() & DISABLEINTS);
+	list_for_each_entry(iter, &swap_asid_h[asid], sw_list){
+		if (!(iter->sw_flags & SW_REFERENCED) || (iter->sw_flags & SW_PINNED))
+			continue;
+		wss++;
+		iter->sw_flags &= ~SW_REFERENCED;
+		iter->sw_pte->pte_entryLO &= (~VALIDON);
+		refresh_TLB(iter->sw_pte);
+	}
+	setSTATUS(getSTATUS() | IECON);
+
+	wset[asid].wss = wss;
+	wset[asid].quota = (wss + WSMARGIN > WSMIN) ? wss + WSMARGIN : WSMIN;
+	wset[asid].last_sample = now;
+	// La nuova stima potrebbe aver liberato spazio per i processi sospesi
+	admit_suspended();
+}
+
+int admission_control(int asid){
+	int total = 0, active = 0;
+	for (int i = 0; i < UPROCMAX; i++)
+		if (image_info[i].support != NULL && !wset[i].suspended){
+			total += wset[i].wss;
+			active++;
+		}
+	// Almeno un processo deve restare attivo, altrimenti nessuno riattiverebbe quelli sospesi
+	if (total <= swap_pool_size || active <= 1)
+		return FALSE;
+	wset[asid].suspended = TRUE;
+	pager_stats.suspensions++;
+	return TRUE;
+}
+
+void admit_suspended(){
+	int total = 0, active = 0;
+	for (int i = 0; i < UPROCMAX; i++)
+		if (image_info[i].support != NULL && !wset[i].suspended){
+			total += wset[i].wss;
+			active++;
+		}
+	for (int i = 0; i < UPROCMAX; i++)
+		if (wset[i].suspended && (active == 0 || total + wset[i].wss <= swap_pool_size)){
+			wset[i].suspended = FALSE;
+			total += wset[i].wss;
+			active++;
+			SYSCALL(VERHOGEN, (memaddr) &wset_sem[i], 0, 0);
+		}
+}
+
+void reset_working_set(int asid){
+	wset[asid].resident = 0;
+	wset[asid].wss = 0;
+	// Finche' il working set non e' stato stimato il processo non ha limiti
+	wset[asid].quota = swap_pool_size;
+	// Il primo campionamento avviene dopo un intervallo completo, quando il processo ha caricato le prime pagine
+	STCK(wset[asid].last_sample);
+	wset[asid].suspended = FALSE;
+	wset_sem[asid] = 0;
+}
+
 int replacement_algorithm(){
 	// Variabile che contiene l'indice della prossima pagina vittima
 	static int next_frame = 0; 
-	int victim_frame = next_frame; 
-	next_frame = (next_frame + 1) % POOLSIZE; 
-	return victim_frame; 
+	// I frame bloccati in memoria vengono saltati
+	for (int i = 0; i < swap_pool_size; i++){
+		int victim_frame = next_frame; 
+		next_frame = (next_frame + 1) % swap_pool_size; 
+		if (!(swap_pool[victim_frame].sw_flags & (SW_PINNED | SW_BUSY)))
+			return victim_frame; 
+	}
+	return -1;
 }
 
-void flash_device_operation(int frame, int operation, support_t *curr_support, int block_number){
-	// Ottenimento del frame asid coinvolto nell'operazione dal/sul flash device
-	int asid = operation == FLASHWRITE ? swap_pool[frame].sw_asid : curr_support->sup_asid - 1;
-	
-	// Ricavo l'indirizzo del device register associato al flash device dell'asid passato come parametro
-	memaddr dev_reg_addr = (memaddr) (DEVREGSTRT_ADDR + ((FLASHINT - 3) * 0x80) + (asid * 0x10));    /* Indirizzo del flash device */
+int flash_transfer(int frame, int operation, int dev, int block){
+	// Ricavo l'indirizzo del device register associato al flash device dev
+	memaddr dev_reg_addr = (memaddr) (DEVREGSTRT_ADDR + ((FLASHINT - 3) * 0x80) + (dev * 0x10));    /* Indirizzo del flash device */
     devreg_t *dev_reg = (devreg_t *) dev_reg_addr;
 	
 	// Acquisizione del mutex sul flash device (per la manipolazione dei device register)
-	SYSCALL(PASSEREN, (memaddr) &flash_sem[curr_support->sup_asid - 1], 0, 0);
+	SYSCALL(PASSEREN, (memaddr) &flash_sem[dev], 0, 0);
 
 	// Operazione di scrittura sul / lettura dal flash device, seguendo il formato descritto in 3.5.5 (pandos)
-	dev_reg->dtp.data0 = (memaddr) (POOLSTART + (frame * PAGESIZE));
-	int command_value = (block_number << 8) | operation;
+	dev_reg->dtp.data0 = (memaddr) FRAMEADDR(frame);
+	int command_value = (block << 8) | operation;
 
-	// Scrittura sul / lettura dal flash device asid-esimo
+	// Scrittura sul / lettura dal flash device dev
 	int flash_status = SYSCALL(DOIO, (memaddr) &(dev_reg->dtp.command), command_value, 0); 
 	
 	// Rilascio del mutex del flash device
-	SYSCALL(VERHOGEN, (memaddr) &flash_sem[curr_support->sup_asid - 1], 0, 0);
-
-	// Se si è verificato un errore, scatta una trap
-	if (flash_status != READY)
-		terminate(curr_support->sup_asid - 1);
+	SYSCALL(VERHOGEN, (memaddr) &flash_sem[dev], 0, 0);
+	if (operation == FLASHWRITE)
+		image_written(dev, block);
+	return flash_status;
 }
 
 void refresh_TLB(pteEntry_t *updated_entry){
+	// La entry potrebbe appartenere ad un altro ASID: EntryHi del processo corrente va ripristinato alla fine
+	unsigned int entry_hi = getENTRYHI();
 	// Carico il campo entryhi della page table entry nel campo EntryHi del registro CP0
 	setENTRYHI(updated_entry->pte_entryHI);
 	// Ricerca di una TLB entry che faccia match con quella presente nel campo CP0.EntryHi
@@ -145,4 +1494,5 @@ void refresh_TLB(pteEntry_t *updated_entry){
 		// TLBWI aggiorna il TLB con entry CP0.EntryHi, CP0.EntryLO
 		TLBWI();
 	} // Altrimenti non c'e' bisogno di aggiornare il TLB, la pgtentry non e' presente
+	setENTRYHI(entry_hi);
 }
\ No newline at end of file
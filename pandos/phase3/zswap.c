@@ -0,0 +1,163 @@
+#include "../h/zswap.h"
+
+// Indirizzo fisico del primo chunk del tier compresso
+HIDDEN memaddr zswap_start;
+// Successore di ogni chunk, nella lista dei chunk liberi o nella codifica di una pagina
+HIDDEN int *zswap_next;
+// Testa della lista dei chunk liberi e numero di chunk liberi
+HIDDEN int zswap_free;
+HIDDEN int zswap_free_chunks;
+// Copie compresse delle pagine, in una tabella hash indicizzata per (asid, pagina)
+HIDDEN zswap_t zswap_table[ZSWAPENTRIES];
+HIDDEN struct list_head zswap_hash[ZSWAPBUCKETS];
+HIDDEN LIST_HEAD(zswap_free_h);
+// Contatori del tier compresso, consultabili dal debugger di uMPS3
+zswap_stats_t zswap_stats;
+
+// Indirizzo della parola i-esima del chunk
+#define CHUNKWORD(chunk, i) ((unsigned int *) (zswap_start + ((chunk) * ZCHUNKWORDS + (i)) * WORDLEN))
+// Bucket della tabella hash che contiene la pagina
+#define ZSWAPHASH(asid, page) (((page) * 7 + (asid)) % ZSWAPBUCKETS)
+
+// Ritorna la copia compressa della pagina, NULL se assente
+HIDDEN zswap_t *zswap_find(int asid, int page){
+	zswap_t *iter;
+	list_for_each_entry(iter, &zswap_hash[ZSWAPHASH(asid, page)], z_list)
+		if (iter->asid == asid && iter->page == page)
+			return iter;
+	return NULL;
+}
+
+void zswap_init(memaddr start, int frames, int *next){
+	zswap_start = start;
+	zswap_next = next;
+	zswap_free = ZNONE;
+	zswap_free_chunks = frames * ZCHUNKSPERFRAME;
+	// Inizialmente tutti i chunk sono liberi
+	for (int i = zswap_free_chunks - 1; i >= 0; i--){
+		zswap_next[i] = zswap_free;
+		zswap_free = i;
+	}
+	INIT_LIST_HEAD(&zswap_free_h);
+	for (int i = 0; i < ZSWAPBUCKETS; i++)
+		INIT_LIST_HEAD(&zswap_hash[i]);
+	for (int i = 0; i < ZSWAPENTRIES; i++)
+		list_add_tail(&(zswap_table[i].z_list), &zswap_free_h);
+	zswap_stats.stores = 0;
+	zswap_stats.same_filled = 0;
+	zswap_stats.loads = 0;
+	zswap_stats.overflows = 0;
+}
+
+int zswap_store(memaddr page_addr, int asid, int page){
+	unsigned int *word = (unsigned int *) page_addr;
+
+	// La codifica e' una sequenza di coppie (parola, ripetizioni): prima se ne calcola la lunghezza
+	int runs = 1;
+	for (int i = 1; i < PAGESIZE / WORDLEN; i++)
+		if (word[i] != word[i - 1])
+			runs++;
+
+	zswap_drop(asid, page);
+	if (list_empty(&zswap_free_h))
+		return FALSE;
+	zswap_t *entry = container_of(zswap_free_h.next, zswap_t, z_list);
+	entry->asid = asid;
+	entry->page = page;
+	if (runs == 1){
+		// Pagina di parole tutte uguali (tipicamente azzerata): basta ricordare la parola
+		entry->chunk = ZNONE;
+		entry->fill = word[0];
+		list_del(&(entry->z_list));
+		list_add(&(entry->z_list), &zswap_hash[ZSWAPHASH(asid, page)]);
+		zswap_stats.stores++;
+		zswap_stats.same_filled++;
+		return TRUE;
+	}
+	int chunks = (runs * 2 + ZCHUNKWORDS - 1) / ZCHUNKWORDS;
+	if (runs * 2 > ZMAXWORDS || chunks > zswap_free_chunks)
+		return FALSE;
+
+	// Estrazione dei chunk dalla lista dei liberi, nello stesso ordine in cui verranno riempiti
+	list_del(&(entry->z_list));
+	list_add(&(entry->z_list), &zswap_hash[ZSWAPHASH(asid, page)]);
+	entry->chunk = zswap_free;
+	int last = zswap_free;
+	for (int i = 1; i < chunks; i++)
+		last = zswap_next[last];
+	zswap_free = zswap_next[last];
+	zswap_next[last] = ZNONE;
+	zswap_free_chunks -= chunks;
+
+	int chunk = entry->chunk, pos = 0;
+	for (int i = 0; i < PAGESIZE / WORDLEN; ){
+		int run = 1;
+		while (i + run < PAGESIZE / WORDLEN && word[i + run] == word[i])
+			run++;
+		*CHUNKWORD(chunk, pos++) = word[i];
+		*CHUNKWORD(chunk, pos++) = run;
+		// ZCHUNKWORDS e' pari, quindi una coppia non e' mai divisa tra due chunk
+		if (pos == ZCHUNKWORDS){
+			chunk = zswap_next[chunk];
+			pos = 0;
+		}
+		i += run;
+	}
+	zswap_stats.stores++;
+	return TRUE;
+}
+
+int zswap_load(memaddr page_addr, int asid, int page){
+	unsigned int *word = (unsigned int *) page_addr;
+	zswap_t *entry = zswap_find(asid, page);
+	if (entry == NULL)
+		return FALSE;
+
+	if (entry->chunk == ZNONE)
+		for (int i = 0; i < PAGESIZE / WORDLEN; i++)
+			word[i] = entry->fill;
+	else {
+		int chunk = entry->chunk, pos = 0;
+		for (int i = 0; i < PAGESIZE / WORDLEN; ){
+			unsigned int value = *CHUNKWORD(chunk, pos++);
+			unsigned int run = *CHUNKWORD(chunk, pos++);
+			if (pos == ZCHUNKWORDS){
+				chunk = zswap_next[chunk];
+				pos = 0;
+			}
+			while (run-- > 0)
+				word[i++] = value;
+		}
+	}
+	// Il frame diventa l'unica copia della pagina, che verra' ricompressa al prossimo rimpiazzamento
+	zswap_drop(asid, page);
+	zswap_stats.loads++;
+	return TRUE;
+}
+
+int zswap_contains(int asid, int page){
+	return zswap_find(asid, page) != NULL;
+}
+
+void zswap_drop(int asid, int page){
+	zswap_t *entry = zswap_find(asid, page);
+	if (entry == NULL)
+		return;
+	// I chunk della codifica tornano in testa alla lista dei liberi
+	for (int chunk = entry->chunk; chunk != ZNONE; ){
+		int next = zswap_next[chunk];
+		zswap_next[chunk] = zswap_free;
+		zswap_free = chunk;
+		zswap_free_chunks++;
+		chunk = next;
+	}
+	list_del(&(entry->z_list));
+	list_add(&(entry->z_list), &zswap_free_h);
+}
+
+void zswap_drop_asid(int asid){
+	// zswap_drop ignora le entry libere, che non si trovano nella tabella hash
+	for (int i = 0; i < ZSWAPENTRIES; i++)
+		if (zswap_table[i].asid == asid)
+			zswap_drop(asid, zswap_table[i].page);
+}
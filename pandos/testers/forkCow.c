@@ -0,0 +1,57 @@
+/*	Test of FORK: parent and child must each see only their own
+ *	writes to the pages they shared copy-on-write at the fork
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define PARENTVAL	0x1111
+#define CHILDVAL	0x2222
+#define SPIN		200000
+
+int shared = 0;
+
+
+/* busy waits for a while, so that the other process can run */
+void spin() {
+	int start;
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	while (SYSCALL(GET_TOD, 0, 0, 0) - start < SPIN)
+		;
+}
+
+
+void main() {
+	int pid, mine, onstack;
+
+	print(WRITETERMINAL, "FORK copy-on-write Test starts\n");
+
+	shared = 0;
+	onstack = 0;
+	pid = SYSCALL(FORK, 0, 0, 0);
+
+	if (pid < 0) {
+		print(WRITETERMINAL, "ERROR: FORK failed\n");
+		SYSCALL(TERMINATE, 0, 0, 0);
+	}
+
+	/* both processes write the global and the stack, then check them after the other one had the chance to write */
+	mine = (pid == 0) ? CHILDVAL : PARENTVAL;
+	shared = mine;
+	onstack = mine;
+	spin();
+
+	if (shared != mine)
+		print(WRITETERMINAL, "ERROR: global variable changed by the other process\n");
+	else if (onstack != mine)
+		print(WRITETERMINAL, "ERROR: stack variable changed by the other process\n");
+	else if (pid == 0)
+		print(WRITETERMINAL, "FORK child Concluded Successfully\n");
+	else
+		print(WRITETERMINAL, "FORK parent Concluded Successfully\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -7,6 +7,7 @@
 */
 
 extern void print (int device, char *str);
+extern void print_num (int device, unsigned int n);
 
 /***************************************************************/
 
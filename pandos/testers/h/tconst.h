@@ -6,3 +6,14 @@
 #define WRITEPRINTER	        3
 #define WRITETERMINAL 	        4
 #define READTERMINAL	        5
+#define FORK			6
+#define PINPAGES		7
+#define UNPINPAGES		8
+#define SBRK			9
+#define MMAP			10
+#define SPAWN			11
+
+/* Support level limits */
+#define PAGESIZE		4096
+#define PINMAX			8
+#define HEAPMAXPAGES		64
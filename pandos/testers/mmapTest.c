@@ -0,0 +1,79 @@
+/*	Test of MMAP: blocks of flash device 0 past the aout image are mapped,
+ *	read and written; the writes must reach the device once the pages
+ *	are evicted. The image area and the swap slots cannot be mapped
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+/* blocks of a 512 block flash device between the image and the swap slots */
+#define MMAPDEV		0
+#define MMAPBLOCK	256
+#define MMAPLEN		2
+#define LASTBLOCK	511
+#define EVICTPAGES	32
+
+
+void main() {
+	int i, j, errors;
+	int *first, *second;
+	char *heap;
+
+	print(WRITETERMINAL, "MMAP Test starts\n");
+	errors = 0;
+
+	if (SYSCALL(MMAP, MMAPDEV, 0, MMAPLEN) != -1) {
+		print(WRITETERMINAL, "ERROR: mapped the aout image\n");
+		errors++;
+	}
+	if (SYSCALL(MMAP, MMAPDEV, LASTBLOCK, 1) != -1) {
+		print(WRITETERMINAL, "ERROR: mapped a swap slot\n");
+		errors++;
+	}
+	if (SYSCALL(MMAP, MMAPDEV, MMAPBLOCK, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: mapped an empty region\n");
+		errors++;
+	}
+
+	first = (int *) SYSCALL(MMAP, MMAPDEV, MMAPBLOCK, MMAPLEN);
+	second = (int *) SYSCALL(MMAP, MMAPDEV, MMAPBLOCK, MMAPLEN);
+	if ((int) first == -1 || (int) second == -1) {
+		print(WRITETERMINAL, "ERROR: MMAP failed\n");
+		SYSCALL(TERMINATE, 0, 0, 0);
+	}
+
+	/* read: both regions are loaded from the same blocks */
+	if (first[0] != second[0] || first[PAGESIZE / 4] != second[PAGESIZE / 4]) {
+		print(WRITETERMINAL, "ERROR: two mappings of the same blocks differ\n");
+		errors++;
+	}
+
+	/* write: a pattern different from what is on the device, through the first region only */
+	for (i = 0; i < MMAPLEN * PAGESIZE / 4; i += 64)
+		first[i] = ~second[i] ^ i;
+
+	/* the pages of both regions are evicted, the dirty ones written back, by touching enough heap pages */
+	heap = (char *) SYSCALL(SBRK, EVICTPAGES * PAGESIZE, 0, 0);
+	if ((int) heap == -1) {
+		print(WRITETERMINAL, "ERROR: SBRK failed\n");
+		SYSCALL(TERMINATE, 0, 0, 0);
+	}
+	for (j = 0; j < 2; j++)
+		for (i = 0; i < EVICTPAGES; i++)
+			heap[i * PAGESIZE] = (char) i;
+
+	/* the second region is loaded again from the blocks written back by the first one */
+	for (i = 0; i < MMAPLEN * PAGESIZE / 4; i += 64)
+		if (first[i] != second[i]) {
+			print(WRITETERMINAL, "ERROR: MMAP write-back lost\n");
+			errors++;
+			break;
+		}
+
+	if (errors == 0)
+		print(WRITETERMINAL, "MMAP Test Concluded Successfully\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,68 @@
+/*	Test of PINPAGES and UNPINPAGES: at most PINMAX pages can be pinned
+ *	at a time, and a request that does not fit pins nothing.
+ *	The kernel also keeps half of the swap pool unpinned, so the
+ *	successful pins expect few other U-procs to be pinning frames
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+char area[(PINMAX + 2) * PAGESIZE];
+
+
+void main() {
+	int i, errors;
+	char *base;
+
+	print(WRITETERMINAL, "Pin limit Test starts\n");
+	errors = 0;
+
+	/* the ranges start at a page boundary, so that len bytes cover exactly len / PAGESIZE pages */
+	base = (char *) (((unsigned int) area + PAGESIZE - 1) & ~(PAGESIZE - 1));
+
+	if (SYSCALL(PINPAGES, (int) base, (PINMAX + 1) * PAGESIZE, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: pinned more than PINMAX pages\n");
+		errors++;
+	}
+
+	if (SYSCALL(PINPAGES, (int) base, 4 * PAGESIZE, 0) != 0) {
+		print(WRITETERMINAL, "ERROR: could not pin 4 pages\n");
+		errors++;
+	}
+	for (i = 0; i < 4; i++)
+		base[i * PAGESIZE] = 'a' + i;
+
+	/* pages that are already pinned do not count twice */
+	if (SYSCALL(PINPAGES, (int) base, 4 * PAGESIZE, 0) != 0) {
+		print(WRITETERMINAL, "ERROR: could not pin the same 4 pages again\n");
+		errors++;
+	}
+
+	/* 4 + 5 pages are over the limit */
+	if (SYSCALL(PINPAGES, (int) (base + 4 * PAGESIZE), 5 * PAGESIZE, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: pinned more than PINMAX pages in two calls\n");
+		errors++;
+	}
+
+	SYSCALL(UNPINPAGES, (int) base, 4 * PAGESIZE, 0);
+
+	/* after the unpin the same budget is available again */
+	if (SYSCALL(PINPAGES, (int) (base + 4 * PAGESIZE), 4 * PAGESIZE, 0) != 0) {
+		print(WRITETERMINAL, "ERROR: unpinned pages still count against the limit\n");
+		errors++;
+	}
+	SYSCALL(UNPINPAGES, (int) (base + 4 * PAGESIZE), 4 * PAGESIZE, 0);
+
+	for (i = 0; i < 4; i++)
+		if (base[i * PAGESIZE] != 'a' + i) {
+			print(WRITETERMINAL, "ERROR: pinned page lost its content\n");
+			errors++;
+		}
+
+	if (errors == 0)
+		print(WRITETERMINAL, "Pin limit Test Concluded Successfully\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
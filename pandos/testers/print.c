@@ -19,3 +19,19 @@ void print(int device, char *str) {
 		SYSCALL (TERMINATE, 0, 0, 0);
 	}
 }
+
+
+/* prints the decimal representation of n */
+void print_num(int device, unsigned int n) {
+
+	char buf[12];
+	int i;
+
+	i = 11;
+	buf[i] = EOS;
+	do {
+		buf[--i] = '0' + n % 10;
+		n /= 10;
+	} while (n > 0);
+	print(device, &buf[i]);
+}
@@ -0,0 +1,77 @@
+/*	Test of SBRK: the heap grows by the requested amount and is usable,
+ *	cannot shrink and cannot grow beyond HEAPMAXPAGES pages
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+
+void main() {
+	int i, errors;
+	char *start, *brk;
+
+	print(WRITETERMINAL, "SBRK Test starts\n");
+	errors = 0;
+
+	/* a zero increment returns the current break, which is the start of the heap */
+	start = (char *) SYSCALL(SBRK, 0, 0, 0);
+	if ((int) start == -1) {
+		print(WRITETERMINAL, "ERROR: SBRK(0) failed\n");
+		SYSCALL(TERMINATE, 0, 0, 0);
+	}
+
+	/* growth: the old break is returned and the new pages can be written and read back */
+	if ((char *) SYSCALL(SBRK, 3 * PAGESIZE, 0, 0) != start) {
+		print(WRITETERMINAL, "ERROR: SBRK did not return the old break\n");
+		errors++;
+	}
+	for (i = 0; i < 3 * PAGESIZE; i += 512)
+		start[i] = (char) (i / 512);
+	for (i = 0; i < 3 * PAGESIZE; i += 512)
+		if (start[i] != (char) (i / 512)) {
+			print(WRITETERMINAL, "ERROR: heap content lost\n");
+			errors++;
+			break;
+		}
+
+	/* shrink: the heap can only grow, the break does not move */
+	if (SYSCALL(SBRK, -PAGESIZE, 0, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: SBRK accepted a negative increment\n");
+		errors++;
+	}
+	brk = (char *) SYSCALL(SBRK, 0, 0, 0);
+	if (brk != start + 3 * PAGESIZE) {
+		print(WRITETERMINAL, "ERROR: the break moved after a rejected SBRK\n");
+		errors++;
+	}
+
+	/* bounds: the heap cannot exceed HEAPMAXPAGES pages, whatever the size of the increment */
+	if (SYSCALL(SBRK, HEAPMAXPAGES * PAGESIZE, 0, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: heap grew beyond HEAPMAXPAGES\n");
+		errors++;
+	}
+	if (SYSCALL(SBRK, 0x7FFFFFFF, 0, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: SBRK accepted an increment that wraps the address space\n");
+		errors++;
+	}
+	if ((char *) SYSCALL(SBRK, (HEAPMAXPAGES - 3) * PAGESIZE, 0, 0) != brk) {
+		print(WRITETERMINAL, "ERROR: could not grow the heap up to HEAPMAXPAGES\n");
+		errors++;
+	}
+	start[HEAPMAXPAGES * PAGESIZE - 1] = 'z';
+	if (start[HEAPMAXPAGES * PAGESIZE - 1] != 'z') {
+		print(WRITETERMINAL, "ERROR: last heap page not usable\n");
+		errors++;
+	}
+	if (SYSCALL(SBRK, 1, 0, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: heap grew beyond HEAPMAXPAGES\n");
+		errors++;
+	}
+
+	if (errors == 0)
+		print(WRITETERMINAL, "SBRK Test Concluded Successfully\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,43 @@
+/*	Test of SPAWN: a flash device holding a tester image starts a new
+ *	U-proc, devices without an aout image are rejected. The new U-proc
+ *	needs a free slot, so fewer than UPROCMAX testers must be running
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+/* the flash device of fibEight in umps3.json, which terminates by itself, and the disk, which holds no aout image */
+#define SPAWNDEV	5
+#define DISKDEV		8
+#define NODEV		9
+
+
+void main() {
+	int child, errors;
+
+	print(WRITETERMINAL, "SPAWN Test starts\n");
+	errors = 0;
+
+	if (SYSCALL(SPAWN, DISKDEV, 0, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: spawned a device without an aout image\n");
+		errors++;
+	}
+	if (SYSCALL(SPAWN, NODEV, 0, 0) != -1 || SYSCALL(SPAWN, -1, 0, 0) != -1) {
+		print(WRITETERMINAL, "ERROR: spawned a device that does not exist\n");
+		errors++;
+	}
+
+	/* the new U-proc gets its own ASID, returned as for FORK */
+	child = SYSCALL(SPAWN, SPAWNDEV, 0, 0);
+	if (child <= 0) {
+		print(WRITETERMINAL, "ERROR: SPAWN of a tester image failed\n");
+		errors++;
+	}
+
+	if (errors == 0)
+		print(WRITETERMINAL, "SPAWN Test Concluded Successfully\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,55 @@
+/*	TLB workload: a working set of 22 pages, larger than the 16 entry TLB.
+ *	HOTPAGES pages are read at every round, while one of COLDPAGES pages
+ *	is read in turn. The number of TLB refills is read from tlb_stats
+ *	with the debugger, the elapsed time is printed at the end
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define HOTPAGES	6
+#define COLDPAGES	14
+#define HOTREADS	4
+#define ROUNDS		2000
+
+int area[(HOTPAGES + COLDPAGES) * PAGESIZE / 4];
+
+
+void main() {
+	int r, h, k, sum;
+	unsigned int start;
+
+	print(WRITETERMINAL, "TLB workload starts\n");
+
+	/* each page is loaded before the rounds, which then cause TLB refills but no page faults if the swap pool has free frames */
+	for (r = 0; r < HOTPAGES + COLDPAGES; r++)
+		area[r * PAGESIZE / 4] = r;
+
+	sum = 0;
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for (r = 0; r < ROUNDS; r++) {
+		for (h = 0; h < HOTPAGES; h++)
+			for (k = 0; k < HOTREADS; k++)
+				sum += area[h * PAGESIZE / 4 + k];
+		sum += area[(HOTPAGES + r % COLDPAGES) * PAGESIZE / 4];
+	}
+
+	print(WRITETERMINAL, "TLB workload elapsed microseconds: ");
+	print_num(WRITETERMINAL, SYSCALL(GET_TOD, 0, 0, 0) - start);
+	print(WRITETERMINAL, "\n");
+
+	/* only the first word of each page is not zero */
+	for (r = 0; r < ROUNDS; r++) {
+		for (h = 0; h < HOTPAGES; h++)
+			sum -= h;
+		sum -= HOTPAGES + r % COLDPAGES;
+	}
+	if (sum == 0)
+		print(WRITETERMINAL, "TLB workload Concluded Successfully\n");
+	else
+		print(WRITETERMINAL, "ERROR: wrong values read\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
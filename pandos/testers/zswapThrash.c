@@ -0,0 +1,78 @@
+/*	Thrashing workload for the compressed swap tier: two arrays, each
+ *	as large as 3/4 of the 128 RAM frames in umps3.json, are read in
+ *	turn so that every pass refaults all the pages of one array. The
+ *	pages of comp compress (one repeated word, or a few runs) and are
+ *	served from the compressed tier, those of raw do not and go to the
+ *	flash devices. The time of each pass is printed, the counters of
+ *	the tier are in zswap_stats and can be read with the debugger
+ */
+
+#include "/usr/local/include/umps3/umps/libumps.h"
+
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define ARRAYPAGES	96
+#define PAGEWORDS	(PAGESIZE / 4)
+#define ROUNDS		3
+/* words checked in each page, enough to fault it in without making the pass CPU bound */
+#define STRIDE		16
+
+unsigned int comp[ARRAYPAGES * PAGEWORDS];
+unsigned int raw[ARRAYPAGES * PAGEWORDS];
+
+
+/* even pages repeat one word, odd pages have 8 runs of equal words */
+unsigned int comp_value(int p, int i) {
+	return (p % 2 == 0) ? p : p * 8 + i / (PAGEWORDS / 8);
+}
+
+/* no two consecutive words are equal */
+unsigned int raw_value(int p, int i) {
+	return (p * PAGEWORDS + i) * 2654435761U;
+}
+
+
+/* reads one array, adds the wrong words to errors and returns the time taken */
+int check(unsigned int *a, int compressible, int *errors) {
+	int p, i;
+	unsigned int start, value;
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for (p = 0; p < ARRAYPAGES; p++)
+		for (i = 0; i < PAGEWORDS; i += STRIDE) {
+			value = compressible ? comp_value(p, i) : raw_value(p, i);
+			if (a[p * PAGEWORDS + i] != value)
+				(*errors)++;
+		}
+	return SYSCALL(GET_TOD, 0, 0, 0) - start;
+}
+
+
+void main() {
+	int r, p, i, errors;
+
+	print(WRITETERMINAL, "zswap thrashing workload starts\n");
+	errors = 0;
+
+	for (p = 0; p < ARRAYPAGES; p++)
+		for (i = 0; i < PAGEWORDS; i++) {
+			comp[p * PAGEWORDS + i] = comp_value(p, i);
+			raw[p * PAGEWORDS + i] = raw_value(p, i);
+		}
+
+	for (r = 0; r < ROUNDS; r++) {
+		print(WRITETERMINAL, "compressible pass microseconds: ");
+		print_num(WRITETERMINAL, check(comp, 1, &errors));
+		print(WRITETERMINAL, "\nincompressible pass microseconds: ");
+		print_num(WRITETERMINAL, check(raw, 0, &errors));
+		print(WRITETERMINAL, "\n");
+	}
+
+	if (errors == 0)
+		print(WRITETERMINAL, "zswap thrashing workload Concluded Successfully\n");
+	else
+		print(WRITETERMINAL, "ERROR: wrong values read after a refault\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}